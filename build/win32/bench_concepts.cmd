@@ -0,0 +1,12 @@
+@echo off
+rem Compares compilation against the core concept libraries loaded as plugins (Release configuration)
+rem and linked into neos (ReleaseStatic configuration). Build both x64 configurations of the solution first.
+rem usage: bench_concepts <solution directory> <schema> <program> [<iterations>]
+setlocal
+set iterations=%4
+if "%iterations%"=="" set iterations=10
+for %%e in (Release\neos.exe ReleaseStatic\neos_static.exe) do (
+    echo %%e
+    (echo s %2& echo l %3& echo bench concepts %iterations%& echo q) | "%~1\x64\%%e"
+)
+endlocal
@@ -1,216 +1,402 @@
-#include <neos/neos.hpp>
-#include <string>
-#include <iostream>
-#include <boost/program_options.hpp>
-#include <neos/context.hpp>
-
-using namespace std::literals::string_literals;
-
-namespace
-{
-    bool command_arg_to_bool(const std::string& aArg)
-    {
-        if (aArg == "true" || aArg == "1" || aArg == "on")
-            return true;
-        else if (aArg == "false" || aArg == "0" || aArg == "off")
-            return false;
-        else
-            throw std::runtime_error("invalid command argument(s)");
-    }
-}
-
-bool process_command(neos::context& aContext, bool& aInteractive, const std::string& aConsoleInput)
-{
-    auto output_compilation_time = [&aContext]()
-    {
-        std::cout << "Compilation time: " <<
-            std::chrono::duration_cast<std::chrono::microseconds>(aContext.compiler().end_time() - aContext.compiler().start_time()).count() / 1000.0 << "ms" << std::endl;
-    };
-    std::vector<std::pair<std::string::const_iterator, std::string::const_iterator>> words;
-    const std::string delimeters{ " " };
-    neolib::tokens(aConsoleInput.cbegin(), aConsoleInput.cend(), delimeters.cbegin(), delimeters.cend(), words);
-    if (words.empty())
-        return true;
-    const std::string command{ words[0].first, words[0].second };
-    if (command.empty())
-        return true;
-    std::string parameters{ words.size() > 1 ? words[1].first : aConsoleInput.cend(), aConsoleInput.cend() };
-    try
-    {
-        if (aInteractive)
-            aContext.evaluate(aConsoleInput);
-        else if (command == "?" || command == "h" || command == "help")
-        {
-            std::cout << "h(elp)\n"
-                << "s(chema) <path to language schema>       Load language scheme\n"
-                << "l(oad) <path to program>                 Load program\n"
-                << "list                                     List program\n"
-                << "c(ompile)                                Compile program\n"
-                << "r(un)                                    Run program\n"
-                << "![<expression>]                          Evaluate expression (enter interactive mode if expression omitted)\n"
-                << ":<input>                                 Input (as stdin)\n"
-                << "q(uit)                                   Quit neos\n"
-                << "lc                                       List loaded concept libraries\n"
-                << "t(race) <0|1|2|3|4|5> [<filter>]         Compiler trace\n"
-                << "m(etrics)                                Display metrics of running programs\n"
-                << std::flush;
-        }
-        else if (command == "s" || command == "schema")
-        {
-            aContext.load_schema(parameters);
-            std::cout << "Language: " << aContext.schema().meta().description + "\nVersion: " + aContext.schema().meta().version << std::endl;
-            if (!aContext.schema().meta().copyright.empty())
-                std::cout << aContext.schema().meta().copyright << std::endl;
-        }
-        else if (command == "l" || command == "load")
-        {
-            aContext.load_program(parameters);
-        }
-        else if (command == "c" || command == "compile")
-        {
-            aContext.compile_program();
-            output_compilation_time();
-        }
-        else if (command == "list")
-        {
-            for (auto const& tu : aContext.program().translationUnits)
-                for (auto const& f : tu.fragments)
-                {
-                    if (f.source_file_path() != std::nullopt)
-                        std::cout << "File '" << *f.source_file_path() << "':" << std::endl;
-                    std::cout << f.source() << std::endl;
-                }
-        }
-        else if (command == "r" || command == "run")
-            aContext.run();
-        else if (command[0] == '!')
-        {
-            if (!aContext.schema_loaded())
-                throw std::runtime_error("no schema loaded");
-            std::string expression(std::next(words[0].first), aConsoleInput.cend());
-            if (!expression.empty())
-            {
-                aContext.evaluate(expression);
-                output_compilation_time();
-            }
-            else
-                aInteractive = true;
-        }
-        else if (command == "lc")
-        {
-            auto print_concept_library = [](auto const& self, const neos::language::i_concept_library& aConceptLibrary, uint32_t aDepth = 0) -> void
-            {
-                std::cout << std::string(aDepth * 2, ' ') << "[" << aConceptLibrary.name() << "]";
-                if (aDepth == 0)
-                    std::cout << " (" << aConceptLibrary.uri() << ")";
-                std::cout << std::endl;
-                for (auto const& conceptLibrary : aConceptLibrary.sublibraries())
-                    self(self, *conceptLibrary.second(), aDepth + 1);
-            };
-            for (auto const& conceptLibrary : aContext.concept_libraries())
-                if (conceptLibrary.second()->depth() == 0)
-                    print_concept_library(print_concept_library, *conceptLibrary.second());
-        }
-        else if (command == "t" || command == "trace")
-        {
-            if (words.size() >= 2)
-                aContext.compiler().set_trace(
-                    boost::lexical_cast<uint32_t>(std::string{ words[1].first, words[1].second }), 
-                    words.size() > 2 ? std::string{ words[2].first, words[2].second } : std::optional<std::string>{});
-            else
-                throw std::runtime_error("invalid command argument(s)");
-        }
-        else if (command == "m" || command == "metrics")
-            std::cout << aContext.metrics();
-        else if (command == "q" || command == "quit")
-            return false;
-        else
-            throw std::runtime_error("unknown command '" + command + "'");
-    }
-    catch (const neos::language::schema::unresolved_references& e)
-    {
-        for (auto const& r : e.references)
-        {
-            std::cerr << "Error: " << aContext.schema_source().to_error_text(*r.node, "unresolved schema reference '" + r.node->name() + "'") << std::endl;
-        }
-        throw;
-    }
-    catch (const neos::context::warning& e)
-    {
-        output_compilation_time();
-        std::cerr << "Warning: " << e.what() << std::endl;
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << "Error: " << e.what() << std::endl;
-    }
-    catch (...)
-    {
-        std::cerr << "Unknown error" << std::endl;
-    }
-    return true;
-}
-
-void main_loop(boost::program_options::variables_map& aOptions)
-{
-    std::cout << "neos " << neos::NEOS_VERSION << std::endl;
-    neos::context context;
-    bool interactive = false;
-    bool first = true;
-    for (;;)
-    {
-        // todo: non-interactive mode (stdin goes straight to vm stdin)
-        if (first)
-        {
-            first = false;
-            if (aOptions.count("s"))
-                process_command(context, interactive, "s " + aOptions["s"].as<std::string>());
-            if (aOptions.count("schema"))
-                process_command(context, interactive, "s " + aOptions["schema"].as<std::string>());
-            if (aOptions.count("trace"))
-                process_command(context, interactive, "t " + boost::lexical_cast<std::string>(aOptions["trace"].as<uint32_t>()));
-            if (aOptions.count("t"))
-                process_command(context, interactive, "t " + boost::lexical_cast<std::string>(aOptions["t"].as<uint32_t>()));
-            if (aOptions.count("program"))
-                for (auto const& p : aOptions["program"].as<std::vector<std::string>>())
-                    process_command(context, interactive, "l " + p);
-            if (aOptions.count("c") || aOptions.count("compile"))
-                process_command(context, interactive, "c");
-        }
-        std::string line;
-        std::cout << (context.schema_loaded() ? context.running() || interactive ? context.schema().meta().name + "> " : context.schema().meta().name + "] " : "] ");
-        std::getline(std::cin, line);
-        if (!process_command(context, interactive, line))
-            return;
-    }
-}
-
-int main(int argc, char* argv[])
-{
-    try
-    {
-        boost::program_options::options_description optionsDescription{ "Allowed options" };
-        optionsDescription.add_options()
-            ("schema", boost::program_options::value<std::string>(), "language schema")
-            ("s", boost::program_options::value<std::string>(), "language schema")
-            ("trace", boost::program_options::value<uint32_t>(), "compiler trace")
-            ("t", boost::program_options::value<uint32_t>(), "compiler trace")
-            ("compile", "compile program")
-            ("c", "compile program")
-            ("program", boost::program_options::value<std::vector<std::string>>(), "program(s) to load");
-        boost::program_options::positional_options_description positionalOptionsDescription;
-        positionalOptionsDescription.add("program", -1);
-        boost::program_options::variables_map options;
-        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).
-            options(optionsDescription).positional(positionalOptionsDescription).run(), options);
-        main_loop(options);
-    }
-    catch (std::logic_error&)
-    {
-        throw;
-    }
-    catch (...)
-    {
-        return EXIT_FAILURE;
-    }
-}
+#include <neos/neos.hpp>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <boost/program_options.hpp>
+#include <neos/context.hpp>
+#include <neos/language/static_concept_libraries.hpp>
+#include <neos/bytecode/text.hpp>
+
+using namespace std::literals::string_literals;
+
+namespace
+{
+    bool command_arg_to_bool(const std::string& aArg)
+    {
+        if (aArg == "true" || aArg == "1" || aArg == "on")
+            return true;
+        else if (aArg == "false" || aArg == "0" || aArg == "off")
+            return false;
+        else
+            throw std::runtime_error("invalid command argument(s)");
+    }
+}
+
+bool process_command(neos::context& aContext, bool& aInteractive, const std::string& aConsoleInput)
+{
+    auto output_compilation_time = [&aContext]()
+    {
+        std::cout << "Compilation time: " <<
+            std::chrono::duration_cast<std::chrono::microseconds>(aContext.compiler().end_time() - aContext.compiler().start_time()).count() / 1000.0 << "ms" << std::endl;
+    };
+    std::vector<std::pair<std::string::const_iterator, std::string::const_iterator>> words;
+    const std::string delimeters{ " " };
+    neolib::tokens(aConsoleInput.cbegin(), aConsoleInput.cend(), delimeters.cbegin(), delimeters.cend(), words);
+    if (words.empty())
+        return true;
+    const std::string command{ words[0].first, words[0].second };
+    if (command.empty())
+        return true;
+    std::string parameters{ words.size() > 1 ? words[1].first : aConsoleInput.cend(), aConsoleInput.cend() };
+    try
+    {
+        if (aInteractive)
+            aContext.evaluate(aConsoleInput);
+        else if (command == "?" || command == "h" || command == "help")
+        {
+            std::cout << "h(elp)\n"
+                << "s(chema) <path to language schema>       Load language scheme\n"
+                << "l(oad) <path to program>                 Load program\n"
+                << "list                                     List program\n"
+                << "c(ompile)                                Compile program\n"
+                << "r(un)                                    Run program\n"
+                << "![<expression>]                          Evaluate expression (enter interactive mode if expression omitted)\n"
+                << ":<input>                                 Input (as stdin)\n"
+                << "q(uit)                                   Quit neos\n"
+                << "lc                                       List loaded concept libraries\n"
+                << "t(race) <0|1|2|3|4|5> [<filter>]         Compiler trace\n"
+                << "p(arser) <probe|speculative>             Compiler parse mode\n"
+                << "b(ackend) <interpreter|table>            Compiler parser backend\n"
+                << "image use <on|off>                       Load and save precompiled schema images\n"
+                << "image dir [<path>]                       Show / set the schema image cache directory\n"
+                << "analyze                                  List grammar warnings for the loaded schema, most expensive first\n"
+                << "profile <on|off|table|json> [<path>]     Per-rule compiler profiling / write profile of last compilation\n"
+                << "m(etrics)                                Display metrics of running programs\n"
+                << "bench trace [<iterations>]               Benchmark compilation with and without trace instrumentation\n"
+                << "bench concepts [<iterations>]            Benchmark compilation against the core concept libraries (static or plugin)\n"
+                << "bench vm [<milliseconds>]                Benchmark VM instructions per second with switch, decoded and threaded dispatch\n"
+                << std::flush;
+        }
+        else if (command == "s" || command == "schema")
+        {
+            aContext.load_schema(parameters);
+            std::cout << "Language: " << aContext.schema().meta().description + "\nVersion: " + aContext.schema().meta().version << std::endl;
+            if (!aContext.schema().meta().copyright.empty())
+                std::cout << aContext.schema().meta().copyright << std::endl;
+            std::cout << "Parse table: " << aContext.schema().parse_table().nodes().size() << " node(s), " << 
+                aContext.schema().parse_table().deterministic_nodes() << " LL(1)" << std::endl;
+            if (!aContext.schema().analysis().warnings().empty())
+                std::cout << "Grammar analysis: " << aContext.schema().analysis().warnings().size() << " warning(s), use 'analyze' to list" << std::endl;
+        }
+        else if (command == "l" || command == "load")
+        {
+            aContext.load_program(parameters);
+        }
+        else if (command == "c" || command == "compile")
+        {
+            aContext.compile_program();
+            output_compilation_time();
+            if (aContext.compiler().mode() == neos::language::compiler::parse_mode::ProbeEmit)
+                std::cout << "Probe memo: " << aContext.compiler().probe_memo_stats().hits << " hit(s), " <<
+                    aContext.compiler().probe_memo_stats().misses << " miss(es)" << std::endl;
+            else
+                std::cout << "Speculation: " << aContext.compiler().speculation_stats().checkpoints << " checkpoint(s), " <<
+                    aContext.compiler().speculation_stats().rollbacks << " rollback(s)" << std::endl;
+            std::cout << "Lookahead: " << aContext.compiler().pruned_alternatives() << " alternative(s) pruned" << std::endl;
+            if (aContext.compiler().backend() == neos::language::compiler::parse_backend::Table)
+                std::cout << "Scanner: " << aContext.compiler().scanned_characters() << " character(s) consumed in runs" << std::endl;
+            std::size_t astNodes = 0u;
+            std::size_t astBytes = 0u;
+            for (auto const& unit : aContext.program().translationUnits)
+            {
+                astNodes += unit.ast.size();
+                astBytes += unit.ast.memory_usage();
+            }
+            std::cout << "AST: " << astNodes << " node(s), " << astBytes << " byte(s)" << std::endl;
+        }
+        else if (command == "list")
+        {
+            for (auto const& tu : aContext.program().translationUnits)
+                for (auto const& f : tu.fragments)
+                {
+                    if (f.source_file_path() != std::nullopt)
+                        std::cout << "File '" << *f.source_file_path() << "':" << std::endl;
+                    std::cout << f.source() << std::endl;
+                }
+        }
+        else if (command == "r" || command == "run")
+            aContext.run();
+        else if (command[0] == '!')
+        {
+            if (!aContext.schema_loaded())
+                throw std::runtime_error("no schema loaded");
+            std::string expression(std::next(words[0].first), aConsoleInput.cend());
+            if (!expression.empty())
+            {
+                aContext.evaluate(expression);
+                output_compilation_time();
+            }
+            else
+                aInteractive = true;
+        }
+        else if (command == "lc")
+        {
+            auto print_concept_library = [](auto const& self, const neos::language::i_concept_library& aConceptLibrary, uint32_t aDepth = 0) -> void
+            {
+                std::cout << std::string(aDepth * 2, ' ') << "[" << aConceptLibrary.name() << "]";
+                if (aDepth == 0)
+                    std::cout << " (" << aConceptLibrary.uri() << ")";
+                std::cout << std::endl;
+                for (auto const& conceptLibrary : aConceptLibrary.sublibraries())
+                    self(self, *conceptLibrary.second(), aDepth + 1);
+            };
+            for (auto const& conceptLibrary : aContext.concept_libraries())
+                if (conceptLibrary.second()->depth() == 0)
+                    print_concept_library(print_concept_library, *conceptLibrary.second());
+        }
+        else if (command == "t" || command == "trace")
+        {
+            if (words.size() >= 2)
+                aContext.compiler().set_trace(
+                    boost::lexical_cast<uint32_t>(std::string{ words[1].first, words[1].second }), 
+                    words.size() > 2 ? std::string{ words[2].first, words[2].second } : std::optional<std::string>{});
+            else
+                throw std::runtime_error("invalid command argument(s)");
+        }
+        else if (command == "p" || command == "parser")
+        {
+            if (parameters == "probe")
+                aContext.compiler().set_mode(neos::language::compiler::parse_mode::ProbeEmit);
+            else if (parameters == "speculative")
+                aContext.compiler().set_mode(neos::language::compiler::parse_mode::Speculative);
+            else
+                throw std::runtime_error("invalid command argument(s)");
+        }
+        else if (command == "b" || command == "backend")
+        {
+            if (parameters == "interpreter")
+                aContext.compiler().set_backend(neos::language::compiler::parse_backend::Interpreter);
+            else if (parameters == "table")
+                aContext.compiler().set_backend(neos::language::compiler::parse_backend::Table);
+            else
+                throw std::runtime_error("invalid command argument(s)");
+        }
+        else if (command == "analyze")
+        {
+            auto const& warnings = aContext.schema().analysis().warnings();
+            for (std::size_t i = 0u; i < warnings.size(); ++i)
+                std::cerr << "Warning: [" << i + 1u << "] " << warnings[i].text << std::endl;
+            std::cout << "Grammar analysis: " << warnings.size() << " warning(s)" << std::endl;
+        }
+        else if (command == "profile")
+        {
+            std::string const action = words.size() > 1 ? std::string{ words[1].first, words[1].second } : std::string{};
+            if (words.size() == 2 && (action == "on" || action == "off"))
+                aContext.compiler().set_profiling(command_arg_to_bool(action));
+            else if ((words.size() == 2 || words.size() == 3) && (action == "table" || action == "json"))
+            {
+                auto const& profile = aContext.compiler().profile();
+                auto write = [&](std::ostream& aOutput)
+                {
+                    if (action == "table")
+                        profile.write_table(aOutput);
+                    else
+                        profile.write_json(aOutput);
+                };
+                if (words.size() == 3)
+                {
+                    std::string const path{ words[2].first, words[2].second };
+                    std::ofstream output{ path };
+                    if (!output)
+                        throw std::runtime_error("cannot open '" + path + "'");
+                    write(output);
+                    std::cout << "Profile written to '" << path << "'" << std::endl;
+                }
+                else
+                    write(std::cout);
+            }
+            else
+                throw std::runtime_error("invalid command argument(s)");
+        }
+        else if (command == "bench")
+        {
+            std::string const benchmark = words.size() > 1 ? std::string{ words[1].first, words[1].second } : std::string{};
+            if (benchmark != "trace" && benchmark != "concepts" && benchmark != "vm")
+                throw std::runtime_error("invalid command argument(s)");
+            if (benchmark == "vm")
+            {
+                uint32_t const milliseconds = words.size() > 2 ? boost::lexical_cast<uint32_t>(std::string{ words[2].first, words[2].second }) : 1000u;
+                if (milliseconds == 0u)
+                    throw std::runtime_error("invalid command argument(s)");
+                // R1 += 10; R1 += -1; R2 -= 3; R2 ^= R1; compare R2 with R1; branch back: integer forms of several widths 
+                // with 64-bit, packed 8-bit and 32-bit immediates and register operands, then an absolute branch
+                neos::text_t text;
+                auto const loop = neos::bytecode::emit(text, neos::bytecode::opcode::ADD, neos::bytecode::registers::R1, neos::bytecode::u64{ 10 });
+                neos::bytecode::emit(text, neos::bytecode::opcode::ADD, neos::bytecode::registers::R1, neos::bytecode::i8{ -1 });
+                neos::bytecode::emit(text, neos::bytecode::opcode::SUB, neos::bytecode::registers::R2, neos::bytecode::u32{ 3 });
+                neos::bytecode::emit<neos::bytecode::u16>(text, neos::bytecode::opcode::XOR, neos::bytecode::registers::R2, neos::bytecode::registers::R1);
+                neos::bytecode::emit<neos::bytecode::i32>(text, neos::bytecode::opcode::CMP, neos::bytecode::registers::R2, neos::bytecode::registers::R1);
+                neos::bytecode::emit(text, neos::bytecode::opcode::B, loop);
+                auto instructions_per_second = [&](neos::bytecode::vm::dispatch aDispatch)
+                {
+                    neos::bytecode::vm::thread vm{ text, aDispatch };
+                    std::this_thread::sleep_for(std::chrono::milliseconds{ milliseconds });
+                    auto const count = vm.count();
+                    auto const elapsed = std::chrono::duration<double>{ std::chrono::steady_clock::now() - vm.start_time() }.count();
+                    vm.terminate();
+                    return count / elapsed;
+                };
+                auto const switched = instructions_per_second(neos::bytecode::vm::dispatch::Switch);
+                std::cout << "Switch dispatch: " << switched / 1000000.0 << " MIPS" << std::endl;
+                auto report = [&](const char* aName, double aInstructionsPerSecond)
+                {
+                    std::cout << aName << " dispatch: " << aInstructionsPerSecond / 1000000.0 << " MIPS";
+                    if (switched > 0.0)
+                        std::cout << " (" << aInstructionsPerSecond / switched << "x)";
+                    std::cout << std::endl;
+                };
+                report("Decoded", instructions_per_second(neos::bytecode::vm::dispatch::Decoded));
+                if (neos::bytecode::vm::threaded_dispatch_available)
+                    report("Threaded", instructions_per_second(neos::bytecode::vm::dispatch::Threaded));
+                else
+                    std::cout << "Threaded dispatch: not available with this compiler" << std::endl;
+            }
+            else
+            {
+                uint32_t const iterations = words.size() > 2 ? boost::lexical_cast<uint32_t>(std::string{ words[2].first, words[2].second }) : 10u;
+                if (iterations == 0u)
+                    throw std::runtime_error("invalid command argument(s)");
+                auto average_compilation_time = [&]()
+                {
+                    double total = 0.0;
+                    for (uint32_t i = 0u; i < iterations; ++i)
+                    {
+                        aContext.compile_program();
+                        total += std::chrono::duration_cast<std::chrono::microseconds>(aContext.compiler().end_time() - aContext.compiler().start_time()).count() / 1000.0;
+                    }
+                    return total / iterations;
+                };
+                if (benchmark == "concepts")
+                {
+                    // run with the Release and ReleaseStatic builds (build/win32/bench_concepts.cmd) to compare the two
+                    auto const average = average_compilation_time();
+                    std::cout << "Core concept libraries: " << (neos::language::static_core_concepts() ? "static" : "plugin") << ", compilation: " << 
+                        average << "ms (average of " << iterations << " compilation(s))" << std::endl;
+                }
+                else
+                {
+                    auto const oldAlwaysTraced = aContext.compiler().always_traced();
+                    try
+                    {
+                        aContext.compiler().set_always_traced(true);
+                        auto const traced = average_compilation_time();
+                        aContext.compiler().set_always_traced(false);
+                        auto const untraced = average_compilation_time();
+                        aContext.compiler().set_always_traced(oldAlwaysTraced);
+                        std::cout << "Traced: " << traced << "ms, untraced: " << untraced << "ms (average of " << iterations << " compilation(s))" << std::endl;
+                        if (traced > 0.0)
+                            std::cout << "Trace overhead removed: " << (traced - untraced) * 100.0 / traced << "%" << std::endl;
+                    }
+                    catch (...)
+                    {
+                        aContext.compiler().set_always_traced(oldAlwaysTraced);
+                        throw;
+                    }
+                }
+            }
+        }
+        else if (command == "image")
+        {
+            if (words.size() == 3 && std::string{ words[1].first, words[1].second } == "use")
+                aContext.set_use_schema_images(command_arg_to_bool(std::string{ words[2].first, words[2].second }));
+            else if (words.size() == 3 && std::string{ words[1].first, words[1].second } == "dir")
+                aContext.set_schema_image_directory(std::string{ words[2].first, words[2].second });
+            else if (words.size() == 2 && std::string{ words[1].first, words[1].second } == "dir")
+                std::cout << aContext.schema_image_directory() << std::endl;
+            else
+                throw std::runtime_error("invalid command argument(s)");
+        }
+        else if (command == "m" || command == "metrics")
+            std::cout << aContext.metrics();
+        else if (command == "q" || command == "quit")
+            return false;
+        else
+            throw std::runtime_error("unknown command '" + command + "'");
+    }
+    catch (const neos::language::schema::unresolved_references& e)
+    {
+        for (auto const& r : e.references)
+        {
+            std::cerr << "Error: " << aContext.schema_source().to_error_text(*r.node, "unresolved schema reference '" + r.node->name() + "'") << std::endl;
+        }
+        throw;
+    }
+    catch (const neos::context::warning& e)
+    {
+        output_compilation_time();
+        std::cerr << "Warning: " << e.what() << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown error" << std::endl;
+    }
+    return true;
+}
+
+void main_loop(boost::program_options::variables_map& aOptions)
+{
+    std::cout << "neos " << neos::NEOS_VERSION << std::endl;
+    neos::context context;
+    bool interactive = false;
+    bool first = true;
+    for (;;)
+    {
+        // todo: non-interactive mode (stdin goes straight to vm stdin)
+        if (first)
+        {
+            first = false;
+            if (aOptions.count("s"))
+                process_command(context, interactive, "s " + aOptions["s"].as<std::string>());
+            if (aOptions.count("schema"))
+                process_command(context, interactive, "s " + aOptions["schema"].as<std::string>());
+            if (aOptions.count("trace"))
+                process_command(context, interactive, "t " + boost::lexical_cast<std::string>(aOptions["trace"].as<uint32_t>()));
+            if (aOptions.count("t"))
+                process_command(context, interactive, "t " + boost::lexical_cast<std::string>(aOptions["t"].as<uint32_t>()));
+            if (aOptions.count("program"))
+                for (auto const& p : aOptions["program"].as<std::vector<std::string>>())
+                    process_command(context, interactive, "l " + p);
+            if (aOptions.count("c") || aOptions.count("compile"))
+                process_command(context, interactive, "c");
+        }
+        std::string line;
+        std::cout << (context.schema_loaded() ? context.running() || interactive ? context.schema().meta().name + "> " : context.schema().meta().name + "] " : "] ");
+        std::getline(std::cin, line);
+        if (!process_command(context, interactive, line))
+            return;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        boost::program_options::options_description optionsDescription{ "Allowed options" };
+        optionsDescription.add_options()
+            ("schema", boost::program_options::value<std::string>(), "language schema")
+            ("s", boost::program_options::value<std::string>(), "language schema")
+            ("trace", boost::program_options::value<uint32_t>(), "compiler trace")
+            ("t", boost::program_options::value<uint32_t>(), "compiler trace")
+            ("compile", "compile program")
+            ("c", "compile program")
+            ("program", boost::program_options::value<std::vector<std::string>>(), "program(s) to load");
+        boost::program_options::positional_options_description positionalOptionsDescription;
+        positionalOptionsDescription.add("program", -1);
+        boost::program_options::variables_map options;
+        boost::program_options::store(boost::program_options::command_line_parser(argc, argv).
+            options(optionsDescription).positional(positionalOptionsDescription).run(), options);
+        main_loop(options);
+    }
+    catch (std::logic_error&)
+    {
+        throw;
+    }
+    catch (...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -1,257 +1,273 @@
-/*
-  vm.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neos/neos.hpp>
-#include <array>
-#include <vector>
-#include <optional>
-#include <thread>
-#include <neos/bytecode/bytecode.hpp>
-#include <neos/bytecode/registers.hpp>
-#include <neos/bytecode/opcodes.hpp>
-
-namespace neos
-{
-    namespace bytecode
-    {
-        namespace vm
-        {
-            namespace exceptions
-            {
-                struct no_text : std::runtime_error { no_text() : std::runtime_error("neos::bytecode::vm: no text") {} };
-                struct invalid_instruction : std::runtime_error { invalid_instruction() : std::runtime_error("neos::bytecode::vm: invalid instruction") {} };
-                struct vm_logic_error : std::logic_error { vm_logic_error() : std::logic_error("neos::bytecode::vm: vm logic error") {} };
-            }
-
-            namespace cpu
-            {
-                namespace registers
-                {
-                    extern thread_local reg_64 r[16];
-                    extern thread_local reg_simd_128 x[16];
-                    extern thread_local reg_simd_256 y[16];
-                    extern thread_local reg_simd_512 z[16];
-                }
-            }
-
-            template <typename DataType> inline DataType& crack_data(reg_data_64& aData);
-            template <> inline u8& crack_data<u8>(reg_data_64& aData) { return aData.u8; }
-            template <> inline u16& crack_data<u16>(reg_data_64& aData) { return aData.u16; }
-            template <> inline u32& crack_data<u32>(reg_data_64& aData) { return aData.u32; }
-            template <> inline u64& crack_data<u64>(reg_data_64& aData) { return aData.u64; }
-            template <> inline i8& crack_data<i8>(reg_data_64& aData) { return aData.i8; }
-            template <> inline i16& crack_data<i16>(reg_data_64& aData) { return aData.i16; }
-            template <> inline i32& crack_data<i32>(reg_data_64& aData) { return aData.i32; }
-            template <> inline i64& crack_data<i64>(reg_data_64& aData) { return aData.i64; }
-            template <> inline f32& crack_data<f32>(reg_data_64& aData) { return aData.f32; }
-            template <> inline f64& crack_data<f64>(reg_data_64& aData) { return aData.f64; }
-
-            template <typename DataType> inline DataType& r(registers aRegister) { return crack_data<DataType>(cpu::registers::r[aRegister - registers::R0]); }
-            template <typename DataType, registers Register> inline DataType& r() { return crack_data<DataType>(cpu::registers::r[Register - registers::R0]); }
-            template <typename DataType> inline DataType& x(registers aRegister) { return crack_data<DataType>(cpu::registers::x[aRegister - registers::X0].d[0]); }
-            template <typename DataType, registers Register> inline DataType& x() { return crack_data<DataType>(cpu::registers::x[Register - registers::X0].d[0]); }
-            template <typename DataType> inline DataType& y(registers aRegister) { return crack_data<DataType>(cpu::registers::y[aRegister - registers::Y0].d[0]); }
-            template <typename DataType, registers Register> inline DataType& y() { return crack_data<DataType>(cpu::registers::y[Register - registers::Y0].d[0]); }
-            template <typename DataType> inline DataType& z(registers aRegister) { return crack_data<DataType>(cpu::registers::z[aRegister - registers::Z0].d[0]); }
-            template <typename DataType, registers Register> inline DataType& z() { return crack_data<DataType>(cpu::registers::z[Register - registers::Z0].d[0]); }
-
-            template <typename DataType> 
-            inline DataType read(registers aRegister)
-            {
-                switch (aRegister)
-                {
-                case registers::R0:
-                    return 0;
-                case registers::R1:
-                case registers::R2:
-                case registers::R3:
-                case registers::R4:
-                case registers::R5:
-                case registers::R6:
-                case registers::R7:
-                case registers::R8:
-                case registers::R9:
-                case registers::R10:
-                case registers::R11:
-                case registers::R12:
-                case registers::R13:
-                case registers::R14:
-                case registers::R15:
-                    return r<DataType>(aRegister);
-                case registers::X0:
-                case registers::X1:
-                case registers::X2:
-                case registers::X3:
-                case registers::X4:
-                case registers::X5:
-                case registers::X6:
-                case registers::X7:
-                case registers::X8:
-                case registers::X9:
-                case registers::X10:
-                case registers::X11:
-                case registers::X12:
-                case registers::X13:
-                case registers::X14:
-                case registers::X15:
-                    return x<DataType>(aRegister);
-                case registers::Y0:
-                case registers::Y1:
-                case registers::Y2:
-                case registers::Y3:
-                case registers::Y4:
-                case registers::Y5:
-                case registers::Y6:
-                case registers::Y7:
-                case registers::Y8:
-                case registers::Y9:
-                case registers::Y10:
-                case registers::Y11:
-                case registers::Y12:
-                case registers::Y13:
-                case registers::Y14:
-                case registers::Y15:
-                    return y<DataType>(aRegister);
-                case registers::Z0:
-                case registers::Z1:
-                case registers::Z2:
-                case registers::Z3:
-                case registers::Z4:
-                case registers::Z5:
-                case registers::Z6:
-                case registers::Z7:
-                case registers::Z8:
-                case registers::Z9:
-                case registers::Z10:
-                case registers::Z11:
-                case registers::Z12:
-                case registers::Z13:
-                case registers::Z14:
-                case registers::Z15:
-                    return z<DataType>(aRegister);
-                }
-            }
-
-            template <typename DataType>
-            inline DataType& write(registers aRegister)
-            {
-                switch (aRegister)
-                {
-                case registers::R0:
-                    throw exceptions::invalid_instruction();
-                case registers::R1:
-                case registers::R2:
-                case registers::R3:
-                case registers::R4:
-                case registers::R5:
-                case registers::R6:
-                case registers::R7:
-                case registers::R8:
-                case registers::R9:
-                case registers::R10:
-                case registers::R11:
-                case registers::R12:
-                case registers::R13:
-                case registers::R14:
-                case registers::R15:
-                    return r<DataType>(aRegister);
-                case registers::X0:
-                case registers::X1:
-                case registers::X2:
-                case registers::X3:
-                case registers::X4:
-                case registers::X5:
-                case registers::X6:
-                case registers::X7:
-                case registers::X8:
-                case registers::X9:
-                case registers::X10:
-                case registers::X11:
-                case registers::X12:
-                case registers::X13:
-                case registers::X14:
-                case registers::X15:
-                    return x<DataType>(aRegister);
-                case registers::Y0:
-                case registers::Y1:
-                case registers::Y2:
-                case registers::Y3:
-                case registers::Y4:
-                case registers::Y5:
-                case registers::Y6:
-                case registers::Y7:
-                case registers::Y8:
-                case registers::Y9:
-                case registers::Y10:
-                case registers::Y11:
-                case registers::Y12:
-                case registers::Y13:
-                case registers::Y14:
-                case registers::Y15:
-                    return y<DataType>(aRegister);
-                case registers::Z0:
-                case registers::Z1:
-                case registers::Z2:
-                case registers::Z3:
-                case registers::Z4:
-                case registers::Z5:
-                case registers::Z6:
-                case registers::Z7:
-                case registers::Z8:
-                case registers::Z9:
-                case registers::Z10:
-                case registers::Z11:
-                case registers::Z12:
-                case registers::Z13:
-                case registers::Z14:
-                case registers::Z15:
-                    return z<DataType>(aRegister);
-                default:
-                    throw exceptions::vm_logic_error();
-                }
-            }
-
-            class thread
-            {
-            public:
-                thread(const text_t& aText);
-            public:
-                bool joinable() const;
-                void join();
-                void terminate();
-                const std::chrono::steady_clock::time_point& start_time() const;
-                uint64_t count() const;
-                std::string metrics() const;
-                reg_64 result() const;
-            private:
-                reg_64 execute();
-            private:
-                const text_t& iText;
-                std::optional<std::thread> iNativeThread;
-                uint64_t iCount;
-                std::atomic<bool> iTerminate;
-                std::chrono::steady_clock::time_point iStartTime;
-                std::atomic<uint64_t> iCountSample;
-                reg_64 iResult;
-            };
-        }
-    }
+/*
+  vm.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <array>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <exception>
+#include <neos/bytecode/bytecode.hpp>
+#include <neos/bytecode/registers.hpp>
+#include <neos/bytecode/opcodes.hpp>
+
+// direct threaded dispatch needs the labels as values extension
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(NEOS_VM_NO_THREADED_DISPATCH)
+#define NEOS_VM_THREADED_DISPATCH
+#endif
+
+namespace neos
+{
+    namespace bytecode
+    {
+        namespace vm
+        {
+            namespace exceptions
+            {
+                struct no_text : std::runtime_error { no_text() : std::runtime_error("neos::bytecode::vm: no text") {} };
+                struct invalid_instruction : std::runtime_error { invalid_instruction() : std::runtime_error("neos::bytecode::vm: invalid instruction") {} };
+                struct division_by_zero : std::runtime_error { division_by_zero() : std::runtime_error("neos::bytecode::vm: division by zero") {} };
+                struct vm_logic_error : std::logic_error { vm_logic_error() : std::logic_error("neos::bytecode::vm: vm logic error") {} };
+            }
+
+            // The register file of one virtual CPU, owned by the VM running it rather than by the OS thread. The 
+            // SIMD banks (2.5 KiB) are allocated the first time an instruction writes to one of them. Operands are 
+            // addressed through slot tables indexed by register number: R0 reads a slot that is never written 
+            // and writes go to a sink, and SIMD registers read as zero until their banks exist. Integer operations 
+            // only record their width, operands and result; the arithmetic bits of FLAGS are computed from them at 
+            // that width when something reads FLAGS.
+            struct alignas(64) cpu_state
+            {
+                enum class flags_source : uint32_t
+                {
+                    None,
+                    Add,
+                    Subtract,
+                    Multiply,
+                    MultiplySigned,
+                    Logic
+                };
+                struct pending_flags
+                {
+                    flags_source source;
+                    uint32_t width;
+                    bool carry;
+                    u64 lhs;
+                    u64 rhs;
+                    u64 result;
+                };
+                static constexpr u64 ArithmeticFlags = 
+                    static_cast<u64>(flag::CF) | static_cast<u64>(flag::PF) | static_cast<u64>(flag::ZF) | static_cast<u64>(flag::SF) | static_cast<u64>(flag::OF);
+                struct simd_banks
+                {
+                    reg_simd_128 x[16];
+                    reg_simd_256 y[16];
+                    reg_simd_512 z[16];
+                };
+                typedef std::array<reg_data_64*, 64> slots_t;
+
+                reg_64 r[16] = {};
+                reg_64 sink = {};
+                pending_flags pendingFlags = { flags_source::None, 64u, false, 0u, 0u, 0u };
+                slots_t readSlots;
+                slots_t writeSlots;
+                std::unique_ptr<simd_banks> simd;
+
+                cpu_state()
+                {
+                    for (std::size_t index = 0u; index < 16u; ++index)
+                        readSlots[index] = writeSlots[index] = &r[index];
+                    writeSlots[0u] = &sink;
+                    for (std::size_t index = 16u; index < readSlots.size(); ++index)
+                    {
+                        readSlots[index] = &r[0u];
+                        writeSlots[index] = nullptr;
+                    }
+                }
+                cpu_state(const cpu_state&) = delete;
+                cpu_state& operator=(const cpu_state&) = delete;
+
+                simd_banks& banks()
+                {
+                    if (!simd)
+                    {
+                        simd = std::make_unique<simd_banks>();
+                        for (std::size_t index = 0u; index < 16u; ++index)
+                        {
+                            readSlots[index + 16u] = writeSlots[index + 16u] = &simd->x[index].d[0];
+                            readSlots[index + 32u] = writeSlots[index + 32u] = &simd->y[index].d[0];
+                            readSlots[index + 48u] = writeSlots[index + 48u] = &simd->z[index].d[0];
+                        }
+                    }
+                    return *simd;
+                }
+                // aWidth is in bits; the operands and result are zero extended from it
+                u64 record_flags(flags_source aSource, uint32_t aWidth, u64 aLhs, u64 aRhs, u64 aResult, bool aCarry = false)
+                {
+                    pendingFlags = pending_flags{ aSource, aWidth, aCarry, aLhs, aRhs, aResult };
+                    return aResult;
+                }
+                u64 flags();
+                void set_flags(u64 aArithmeticFlags);
+            };
+
+            template <typename DataType> inline DataType& crack_data(reg_data_64& aData);
+            template <> inline u8& crack_data<u8>(reg_data_64& aData) { return aData.u8; }
+            template <> inline u16& crack_data<u16>(reg_data_64& aData) { return aData.u16; }
+            template <> inline u32& crack_data<u32>(reg_data_64& aData) { return aData.u32; }
+            template <> inline u64& crack_data<u64>(reg_data_64& aData) { return aData.u64; }
+            template <> inline i8& crack_data<i8>(reg_data_64& aData) { return aData.i8; }
+            template <> inline i16& crack_data<i16>(reg_data_64& aData) { return aData.i16; }
+            template <> inline i32& crack_data<i32>(reg_data_64& aData) { return aData.i32; }
+            template <> inline i64& crack_data<i64>(reg_data_64& aData) { return aData.i64; }
+            template <> inline f32& crack_data<f32>(reg_data_64& aData) { return aData.f32; }
+            template <> inline f64& crack_data<f64>(reg_data_64& aData) { return aData.f64; }
+
+            template <typename DataType> inline DataType& r(cpu_state& aState, registers aRegister) { return crack_data<DataType>(aState.r[aRegister - registers::R0]); }
+            template <typename DataType, registers Register> inline DataType& r(cpu_state& aState) { return crack_data<DataType>(aState.r[Register - registers::R0]); }
+            template <typename DataType> inline DataType& x(cpu_state& aState, registers aRegister) { return crack_data<DataType>(aState.banks().x[aRegister - registers::X0].d[0]); }
+            template <typename DataType, registers Register> inline DataType& x(cpu_state& aState) { return crack_data<DataType>(aState.banks().x[Register - registers::X0].d[0]); }
+            template <typename DataType> inline DataType& y(cpu_state& aState, registers aRegister) { return crack_data<DataType>(aState.banks().y[aRegister - registers::Y0].d[0]); }
+            template <typename DataType, registers Register> inline DataType& y(cpu_state& aState) { return crack_data<DataType>(aState.banks().y[Register - registers::Y0].d[0]); }
+            template <typename DataType> inline DataType& z(cpu_state& aState, registers aRegister) { return crack_data<DataType>(aState.banks().z[aRegister - registers::Z0].d[0]); }
+            template <typename DataType, registers Register> inline DataType& z(cpu_state& aState) { return crack_data<DataType>(aState.banks().z[Register - registers::Z0].d[0]); }
+
+            template <typename DataType> 
+            inline DataType read(cpu_state& aState, registers aRegister)
+            {
+                return crack_data<DataType>(*aState.readSlots[static_cast<std::size_t>(aRegister)]);
+            }
+
+            template <typename DataType>
+            inline DataType& write(cpu_state& aState, registers aRegister)
+            {
+                auto slot = aState.writeSlots[static_cast<std::size_t>(aRegister)];
+                if (slot == nullptr)
+                {
+                    aState.banks();
+                    slot = aState.writeSlots[static_cast<std::size_t>(aRegister)];
+                }
+                return crack_data<DataType>(*slot);
+            }
+
+            // The text decoded once into an aligned array. An entry has its operation, its registers resolved, its 
+            // immediate sign or zero extended and the index of the entry executed next (a branch's target for a 
+            // branch; a conditional branch keeps its condition in r1 and its target's index in immediate). An integer 
+            // data instruction keeps the index of the handler specialised on its instruction, data type and operand 
+            // kind in form. Byte PCs map to entries so execution can still continue at any PC; text first reached 
+            // that way is decoded on demand.
+            class decoded_text
+            {
+            public:
+                typedef uint32_t index_type;
+                static constexpr index_type None = 0xFFFFFFFFu;
+                static constexpr index_type End = 0u;
+                enum class operation : uint32_t
+                {
+                    Nop,
+                    Branch,
+                    BranchIf,
+                    Integer,
+                    Generic,
+                    Invalid,
+                    End
+                };
+                struct alignas(32) instruction
+                {
+                    const void* handler;
+                    u64 immediate;
+                    index_type next;
+                    uint32_t pc;
+                    operation op;
+                    uint8_t r1;
+                    uint8_t r2;
+                    uint16_t form;
+                };
+                typedef std::vector<instruction> instructions_t;
+            public:
+                decoded_text(const text_t& aText);
+            public:
+                const instructions_t& instructions() const;
+                const instruction& operator[](index_type aIndex) const;
+                index_type index_of(u64 aPC);
+                void bind(const void* const* aHandlers, const void* const* aIntegerHandlers);
+            private:
+                bool decodable(u64 aPC) const;
+                void decode(u64 aPC);
+                instruction decode(u64 aPC, u64& aNextPC, std::optional<u64>& aTarget) const;
+            private:
+                const text_t& iText;
+                instructions_t iInstructions;
+                std::vector<index_type> iIndex;
+                std::size_t iBound;
+            };
+
+            enum class dispatch : uint32_t
+            {
+                Switch,
+                Decoded,
+                Threaded
+            };
+
+#ifdef NEOS_VM_THREADED_DISPATCH
+            constexpr bool threaded_dispatch_available = true;
+#else
+            constexpr bool threaded_dispatch_available = false;
+#endif
+            constexpr dispatch default_dispatch = threaded_dispatch_available ? dispatch::Threaded : dispatch::Decoded;
+
+            class thread
+            {
+            public:
+                thread(const text_t& aText, dispatch aDispatch = default_dispatch);
+            public:
+                bool joinable() const;
+                void join();
+                void terminate();
+                const std::chrono::steady_clock::time_point& start_time() const;
+                uint64_t count() const;
+                std::string metrics() const;
+                reg_64 result() const;
+            private:
+                reg_64 execute();
+                reg_64 execute_switch();
+                reg_64 execute_decoded();
+#ifdef NEOS_VM_THREADED_DISPATCH
+                reg_64 execute_threaded();
+#endif
+                decoded_text::index_type execute_generic(const decoded_text::instruction& aInstruction);
+            private:
+                const text_t& iText;
+                dispatch iDispatch;
+                cpu_state iState;
+                std::optional<decoded_text> iDecoded;
+                std::optional<std::thread> iNativeThread;
+                uint64_t iCount;
+                std::atomic<bool> iTerminate;
+                std::chrono::steady_clock::time_point iStartTime;
+                std::atomic<uint64_t> iCountSample;
+                reg_64 iResult;
+                std::exception_ptr iError;
+            };
+        }
+    }
 }
\ No newline at end of file
@@ -1,76 +1,181 @@
-/*
-  ast.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neos/neos.hpp>
-#include <neos/language/symbols.hpp>
-#include <neos/language/i_concept.hpp>
-
-namespace neos
-{
-    namespace language
-    {
-        class ast
-        {
-        public:
-            class node : public std::variant<i_concept const*, symbol_table_t::iterator>
-            {
-            public:
-                typedef std::vector<std::unique_ptr<node>> children_t;
-            public:
-                node() : iParent{ nullptr }
-                {
-                }
-                node(node& aParent) : iParent{ &aParent }
-                {
-                }
-            public:
-                children_t const& children() const
-                {
-                    return iChildren;
-                }
-                children_t& children()
-                {
-                    return iChildren;
-                }
-            private:
-                node* iParent;
-                children_t iChildren;
-            };
-        public:
-            ast(symbol_table_t& aSymbolTable) : iSymbolTable{ aSymbolTable }
-            {
-            }
-            ast(ast const& aOther) : iSymbolTable{ aOther.iSymbolTable }
-            {
-            }
-        public:
-            ast& operator=(ast const& aOther)
-            {
-                this->~ast();
-                new (this) ast{ aOther };
-                return *this;
-            }
-        private:
-            symbol_table_t& iSymbolTable;
-            std::optional<node> iRoot;
-        };
-    }
-}
\ No newline at end of file
+/*
+  ast.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include <neos/language/symbols.hpp>
+#include <neos/language/i_concept.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        class i_source_fragment;
+
+        // Flat syntax tree built from the fold stream. Nodes are kept in pre-order in one array of 32-byte records; a 
+        // node's subtree is the range [index, subtreeEnd) of the node array so its first child, if any, follows it and 
+        // each further child starts where the previous child's subtree ends. While a fragment is being compiled nodes 
+        // are added and adopted in a separate pending array; compact() appends them to the tree once they are final. 
+        // Identifier nodes carry the handle of their interned name. A node's kind is a dense per-tree ID of the exact 
+        // concept object it was built from, not its concept_type: concept types are per name and not every concept 
+        // has one.
+        class ast
+        {
+        public:
+            typedef uint32_t node_index;
+            typedef uint32_t concept_id;
+            typedef uint32_t fragment_id;
+            static constexpr node_index None = 0xFFFFFFFFu;
+            struct source_span
+            {
+                fragment_id fragment;
+                uint32_t first;
+                uint32_t last;
+            };
+            struct node
+            {
+                concept_id kind;
+                node_index parent;
+                node_index subtreeEnd;
+                uint32_t childCount;
+                source_span source;
+                symbol_handle_t symbol;
+            };
+            static_assert(sizeof(node) == 32u, "neos::language::ast::node should be 32 bytes");
+            typedef std::vector<node> nodes_t;
+            class children_range
+            {
+            public:
+                class const_iterator
+                {
+                public:
+                    typedef std::forward_iterator_tag iterator_category;
+                    typedef node_index value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef const node_index* pointer;
+                    typedef node_index reference;
+                public:
+                    const_iterator(const nodes_t& aNodes, node_index aIndex) : iNodes{ &aNodes }, iIndex{ aIndex }
+                    {
+                    }
+                public:
+                    node_index operator*() const
+                    {
+                        return iIndex;
+                    }
+                    const_iterator& operator++()
+                    {
+                        iIndex = (*iNodes)[iIndex].subtreeEnd;
+                        return *this;
+                    }
+                    const_iterator operator++(int)
+                    {
+                        auto result = *this;
+                        ++*this;
+                        return result;
+                    }
+                    bool operator==(const const_iterator& aOther) const
+                    {
+                        return iIndex == aOther.iIndex;
+                    }
+                    bool operator!=(const const_iterator& aOther) const
+                    {
+                        return !(*this == aOther);
+                    }
+                private:
+                    const nodes_t* iNodes;
+                    node_index iIndex;
+                };
+            public:
+                children_range(const nodes_t& aNodes, node_index aParent) : 
+                    iBegin{ aNodes, aParent + 1u }, iEnd{ aNodes, aNodes[aParent].subtreeEnd }, iSize{ aNodes[aParent].childCount }
+                {
+                }
+            public:
+                const_iterator begin() const
+                {
+                    return iBegin;
+                }
+                const_iterator end() const
+                {
+                    return iEnd;
+                }
+                std::size_t size() const
+                {
+                    return iSize;
+                }
+                bool empty() const
+                {
+                    return iSize == 0u;
+                }
+            private:
+                const_iterator iBegin;
+                const_iterator iEnd;
+                std::size_t iSize;
+            };
+        private:
+            struct pending_node
+            {
+                concept_id kind;
+                node_index parent;
+                node_index firstChild;
+                node_index nextSibling;
+                source_span source;
+                symbol_handle_t symbol;
+            };
+            typedef std::vector<pending_node> pending_nodes_t;
+        public:
+            ast(symbol_table_t& aSymbolTable);
+            ast(ast const& aOther);
+        public:
+            ast& operator=(ast const& aOther);
+        public:
+            bool empty() const;
+            std::size_t size() const;
+            const nodes_t& nodes() const;
+            const node& operator[](node_index aIndex) const;
+            children_range children(node_index aIndex) const;
+            const i_concept& concept_of(concept_id aKind) const;
+            const i_source_fragment& fragment_of(fragment_id aFragment) const;
+            const symbol_table_t& symbols() const;
+            std::size_t memory_usage() const;
+        public:
+            node_index add(const i_concept& aConcept, const i_source_fragment& aFragment, uint32_t aFirst, uint32_t aLast);
+            void adopt(node_index aParent, node_index aChild);
+            void resolve(node_index aNode, const i_concept& aInstance);
+            void compact();
+            void clear();
+        private:
+            concept_id intern(const i_concept& aConcept);
+            fragment_id intern(const i_source_fragment& aFragment);
+        private:
+            symbol_table_t& iSymbolTable;
+            nodes_t iNodes;
+            pending_nodes_t iPending;
+            std::vector<const i_concept*> iConcepts;
+            std::vector<bool> iIdentifiers;
+            std::unordered_map<const i_concept*, concept_id> iConceptIds;
+            std::vector<const i_source_fragment*> iFragments;
+        };
+    }
+}
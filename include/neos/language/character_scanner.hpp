@@ -0,0 +1,52 @@
+/*
+  character_scanner.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <array>
+#include <neos/language/character_set.hpp>
+
+namespace neos::language
+{
+    // Finds the length of the leading run of characters belonging to a character class; classes made of 
+    // a handful of byte ranges (identifiers, digits, whitespace) are scanned with SIMD range compares.
+    class character_scanner
+    {
+    public:
+        static constexpr std::size_t MaxRanges = 8u;
+    public:
+        struct range
+        {
+            unsigned char first;
+            unsigned char last;
+        };
+        typedef std::array<range, MaxRanges> ranges_t;
+    public:
+        character_scanner(const character_set& aCharacters = character_set{});
+    public:
+        const character_set& characters() const;
+        bool vectorized() const;
+        std::size_t scan(const char* aFirst, const char* aLast) const;
+    private:
+        character_set iCharacters;
+        ranges_t iRanges;
+        std::size_t iRangeCount;
+    };
+}
@@ -0,0 +1,107 @@
+/*
+  character_set.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <array>
+
+namespace neos::language
+{
+    class character_set
+    {
+    public:
+        typedef std::array<uint64_t, 4> bits_t;
+    public:
+        constexpr character_set() :
+            iBits{}
+        {
+        }
+        constexpr character_set(const bits_t& aBits) :
+            iBits{ aBits }
+        {
+        }
+    public:
+        static constexpr character_set all()
+        {
+            return character_set{ bits_t{ ~0ull, ~0ull, ~0ull, ~0ull } };
+        }
+    public:
+        bool test(char aCharacter) const
+        {
+            auto const ch = static_cast<unsigned char>(aCharacter);
+            return (iBits[ch >> 6u] & (1ull << (ch & 63u))) != 0ull;
+        }
+        character_set& set(char aCharacter)
+        {
+            auto const ch = static_cast<unsigned char>(aCharacter);
+            iBits[ch >> 6u] |= (1ull << (ch & 63u));
+            return *this;
+        }
+        character_set& set(char aFirst, char aLast)
+        {
+            for (auto ch = static_cast<uint32_t>(static_cast<unsigned char>(aFirst)); ch <= static_cast<unsigned char>(aLast); ++ch)
+                set(static_cast<char>(ch));
+            return *this;
+        }
+        bool empty() const
+        {
+            return (iBits[0] | iBits[1] | iBits[2] | iBits[3]) == 0ull;
+        }
+        bool full() const
+        {
+            return (iBits[0] & iBits[1] & iBits[2] & iBits[3]) == ~0ull;
+        }
+        std::size_t count() const
+        {
+            std::size_t result = 0u;
+            for (auto bits : iBits)
+                for (; bits != 0ull; bits &= bits - 1ull)
+                    ++result;
+            return result;
+        }
+        const bits_t& bits() const
+        {
+            return iBits;
+        }
+    public:
+        character_set& operator|=(const character_set& aOther)
+        {
+            for (std::size_t i = 0u; i < iBits.size(); ++i)
+                iBits[i] |= aOther.iBits[i];
+            return *this;
+        }
+        character_set& operator&=(const character_set& aOther)
+        {
+            for (std::size_t i = 0u; i < iBits.size(); ++i)
+                iBits[i] &= aOther.iBits[i];
+            return *this;
+        }
+        bool operator==(const character_set& aOther) const
+        {
+            return iBits == aOther.iBits;
+        }
+        bool operator!=(const character_set& aOther) const
+        {
+            return !(*this == aOther);
+        }
+    private:
+        bits_t iBits;
+    };
+}
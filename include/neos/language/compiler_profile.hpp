@@ -0,0 +1,96 @@
+/*
+  compiler_profile.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <neos/language/i_concept.hpp>
+#include <neos/language/i_schema_node_atom.hpp>
+
+namespace neos::language
+{
+    // Per-rule and per-concept counters gathered by the compiler while profiling. Rule names and concept names 
+    // are captured when first seen so a profile can still be written after its schema has gone.
+    class compiler_profile
+    {
+    public:
+        enum class parser : uint32_t
+        {
+            Parse,
+            ParseTokens
+        };
+        struct rule
+        {
+            std::string name;
+            uint64_t parseCalls;
+            uint64_t parseTokensCalls;
+            uint64_t probeCalls;
+            uint64_t emitCalls;
+            uint64_t noMatches;
+            uint64_t bytesConsumed;
+            std::chrono::nanoseconds inclusiveTime;
+            std::chrono::nanoseconds exclusiveTime;
+        };
+        struct concept_counters
+        {
+            std::string name;
+            uint64_t instantiations;
+            uint64_t folds;
+        };
+        typedef std::unordered_map<const i_schema_node_atom*, rule> rules_t;
+        typedef std::unordered_map<const i_concept*, concept_counters> concepts_t;
+    private:
+        struct frame
+        {
+            const i_schema_node_atom* rule;
+            std::chrono::steady_clock::time_point start;
+            std::chrono::nanoseconds children;
+        };
+        typedef std::vector<frame> frames_t;
+    public:
+        bool empty() const;
+        const rules_t& rules() const;
+        const concepts_t& concepts() const;
+        void clear();
+    public:
+        void enter(const i_schema_node_atom& aRule);
+        void leave(parser aParser, compiler_pass aPass, bool aMatched, std::size_t aConsumed);
+        void instantiated(const i_concept& aConcept);
+        void folded(const i_concept& aConcept);
+    public:
+        void write_table(std::ostream& aOutput) const;
+        void write_json(std::ostream& aOutput) const;
+    private:
+        rule& entry(const i_schema_node_atom& aRule);
+        concept_counters& entry(const i_concept& aConcept);
+        std::vector<const rule*> sorted_rules() const;
+        std::vector<const concept_counters*> sorted_concepts() const;
+    private:
+        rules_t iRules;
+        concepts_t iConcepts;
+        frames_t iFrames;
+        // a recursive rule's inclusive time is only taken from its outermost invocation
+        std::unordered_map<const i_schema_node_atom*, uint32_t> iActive;
+    };
+}
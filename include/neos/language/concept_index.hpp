@@ -0,0 +1,75 @@
+/*
+  concept_index.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <neolib/core/reference_counted.hpp>
+#include <neos/language/i_concept.hpp>
+#include <neos/language/i_concept_library.hpp>
+
+namespace neos::language
+{
+    // Open addressing hash table over every concept of every instantiated concept library keyed by interned 
+    // name. Different concepts defined under the same name by two libraries are collected as collisions as 
+    // libraries are added and the name is then ambiguous: it no longer resolves to either concept so that 
+    // which definition is used never depends on the order in which libraries were instantiated.
+    class concept_index
+    {
+    public:
+        struct collision
+        {
+            std::string name;
+            std::string library;
+            std::string otherLibrary;
+        };
+        typedef std::vector<collision> collision_list;
+    public:
+        concept_index();
+    public:
+        void build(const concept_libraries_t& aConceptLibraries);
+        void add(const i_concept_library& aLibrary);
+        neolib::ref_ptr<i_concept> find(std::string_view aName) const;
+        bool ambiguous(std::string_view aName) const;
+        std::size_t size() const;
+        const collision_list& collisions() const;
+    private:
+        struct slot
+        {
+            std::size_t hash;
+            uint32_t name;
+            const i_concept_library* library;
+            neolib::ref_ptr<i_concept> concept_;
+            bool ambiguous;
+        };
+        static constexpr uint32_t NoName = 0xFFFFFFFFu;
+    private:
+        void reserve(std::size_t aConcepts);
+        slot& find_slot(std::size_t aHash, std::string_view aName);
+        const slot* find_slot(std::string_view aName) const;
+    private:
+        std::vector<std::string> iNames;
+        std::vector<slot> iSlots;
+        std::size_t iMask;
+        collision_list iCollisions;
+    };
+}
@@ -1,112 +1,152 @@
-/*
-  concept_library_plugin.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neos/neos.hpp>
-#include <boost/dll.hpp>
-#include <neolib/core/string.hpp>
-#include <neolib/core/reference_counted.hpp>
-#include <neolib/app/version.hpp>
-#include <neolib/app/i_application.hpp>
-#include <neos/language/i_concept_library.hpp>
-
-namespace neos
-{
-    namespace language
-    {
-        template <typename ConceptLibrary>
-        class concept_library_plugin : public neolib::reference_counted<neolib::i_plugin>
-        {
-        public:
-            typedef ConceptLibrary concept_library_type;
-        public:
-            concept_library_plugin(
-                const neolib::uuid& aId = concept_library_type::library_id(),
-                const std::string& aName = concept_library_type::library_name(),
-                const std::string& aDescription = {},
-                const neolib::version aVersion = {},
-                const std::string& aCopyright = {}) :
-                iId{ aId },
-                iName{ aName },
-                iDescription{ aDescription },
-                iVersion{ aVersion },
-                iCopyright{ aCopyright },
-                iLoaded{ false }
-            {
-            }
-        public:
-            bool discover(const neolib::uuid& aId, void*& aObject) override
-            {
-                if (aId == i_concept_library::iid())
-                {
-                    aObject = new concept_library_type{ "file:///" + boost::dll::this_line_location().string() };
-                    return true;
-                }
-                return false;
-            }
-        public:
-            const neolib::uuid& id() const override
-            {
-                return iId;
-            }
-            const neolib::i_string& name() const override
-            {
-                return iName;
-            }
-            const neolib::i_string& description() const override
-            {
-                return iDescription;
-            }
-            const neolib::i_version& version() const override
-            {
-                return iVersion;
-            }
-            const neolib::i_string& copyright() const override
-            {
-                return iCopyright;
-            }
-            bool load() override
-            {
-                iLoaded = true;
-                return true;
-            }
-            bool unload() override
-            {
-                iLoaded = false;
-                return true;
-            }
-            bool loaded() const override
-            {
-                return iLoaded;
-            }
-            bool open_uri(const neolib::i_string& aUri) override
-            {
-                return false;
-            }
-        private:
-            neolib::uuid iId;
-            neolib::string iName;
-            neolib::string iDescription;
-            neolib::version iVersion;
-            neolib::string iCopyright;
-            bool iLoaded;
-        };
-    }
+/*
+  concept_library_plugin.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <vector>
+#include <boost/dll.hpp>
+#include <neolib/core/string.hpp>
+#include <neolib/core/reference_counted.hpp>
+#include <neolib/app/version.hpp>
+#include <neolib/app/i_application.hpp>
+#include <neos/language/i_concept_library.hpp>
+#include <neos/language/i_concept_library_manifest.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        class concept_library_manifest : public neolib::reference_counted<i_concept_library_manifest>
+        {
+        public:
+            concept_library_manifest(const std::string& aLibraryName, const std::vector<std::string>& aSublibraryNames, const std::vector<std::string>& aConceptNamespaces) :
+                iLibraryName{ aLibraryName }, iSublibraryNames{ aSublibraryNames }, iConceptNamespaces{ aConceptNamespaces.begin(), aConceptNamespaces.end() }
+            {
+            }
+        public:
+            const neolib::i_string& library_name() const override
+            {
+                return iLibraryName;
+            }
+            bool provides(const neolib::i_string& aLibraryName) const override
+            {
+                auto const name = aLibraryName.to_std_string();
+                return name == iLibraryName.to_std_string() ||
+                    std::find(iSublibraryNames.begin(), iSublibraryNames.end(), name) != iSublibraryNames.end();
+            }
+            uint32_t concept_namespace_count() const override
+            {
+                return static_cast<uint32_t>(iConceptNamespaces.size());
+            }
+            const neolib::i_string& concept_namespace(uint32_t aIndex) const override
+            {
+                return iConceptNamespaces.at(aIndex);
+            }
+        private:
+            neolib::string iLibraryName;
+            std::vector<std::string> iSublibraryNames;
+            std::vector<neolib::string> iConceptNamespaces;
+        };
+
+        template <typename ConceptLibrary>
+        class concept_library_plugin : public neolib::reference_counted<neolib::i_plugin>
+        {
+        public:
+            typedef ConceptLibrary concept_library_type;
+        public:
+            concept_library_plugin(
+                const neolib::uuid& aId = concept_library_type::library_id(),
+                const std::string& aName = concept_library_type::library_name(),
+                const std::string& aDescription = {},
+                const neolib::version aVersion = concept_library_type::library_version(),
+                const std::string& aCopyright = {}) :
+                iId{ aId },
+                iName{ aName },
+                iDescription{ aDescription },
+                iVersion{ aVersion },
+                iCopyright{ aCopyright },
+                iLoaded{ false }
+            {
+            }
+        public:
+            bool discover(const neolib::uuid& aId, void*& aObject) override
+            {
+                if (aId == i_concept_library::iid())
+                {
+                    aObject = new concept_library_type{ "file:///" + boost::dll::this_line_location().string() };
+                    return true;
+                }
+                else if (aId == i_concept_library_manifest::iid())
+                {
+                    aObject = new concept_library_manifest{ concept_library_type::library_name(), concept_library_type::sublibrary_names(), concept_library_type::concept_namespaces() };
+                    return true;
+                }
+                return false;
+            }
+        public:
+            const neolib::uuid& id() const override
+            {
+                return iId;
+            }
+            const neolib::i_string& name() const override
+            {
+                return iName;
+            }
+            const neolib::i_string& description() const override
+            {
+                return iDescription;
+            }
+            const neolib::i_version& version() const override
+            {
+                return iVersion;
+            }
+            const neolib::i_string& copyright() const override
+            {
+                return iCopyright;
+            }
+            bool load() override
+            {
+                iLoaded = true;
+                return true;
+            }
+            bool unload() override
+            {
+                iLoaded = false;
+                return true;
+            }
+            bool loaded() const override
+            {
+                return iLoaded;
+            }
+            bool open_uri(const neolib::i_string& aUri) override
+            {
+                return false;
+            }
+        private:
+            neolib::uuid iId;
+            neolib::string iName;
+            neolib::string iDescription;
+            neolib::version iVersion;
+            neolib::string iCopyright;
+            bool iLoaded;
+        };
+    }
 }
\ No newline at end of file
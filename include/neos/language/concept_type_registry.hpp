@@ -0,0 +1,61 @@
+/*
+  concept_type_registry.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <string>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <neos/language/i_concept.hpp>
+#include <neos/language/i_concept_library.hpp>
+
+namespace neos::language
+{
+    // Interns the names of the concepts of each batch of newly instantiated concept libraries as dense types 
+    // ordered so that each concept's namespace is a contiguous interval, freezes the parent() hierarchy into 
+    // Euler tour intervals and then hands each new concept its type. Registration only appends: the types and 
+    // intervals of a batch follow those of earlier batches and a concept registered earlier is never given a 
+    // new type, as other contexts may be reading it. A namespace interval therefore only covers the names of 
+    // its own batch (the registry instantiates libraries with overlapping concept namespaces together). Only 
+    // the first concept registered under a name owns that name's lineage; any other concept of the same name, 
+    // and any concept with an ancestor from an earlier batch or that does not own its name, keeps an unfrozen 
+    // lineage and is related by walking parent().
+    class concept_type_registry : public i_concept_type_registry
+    {
+    public:
+        concept_type_registry();
+    public:
+        void register_types(const concept_libraries_t& aNewConceptLibraries);
+    public:
+        concept_type type(const neolib::i_string& aName) const override;
+        concept_type type(const i_concept& aConcept) const override;
+        concept_type type(const std::string& aName) const;
+        std::size_t types() const;
+    private:
+        void freeze_hierarchy(const concept_libraries_t& aNewConceptLibraries, const std::vector<std::string>& aNames);
+    private:
+        mutable std::shared_mutex iMutex;
+        std::unordered_map<std::string, concept_type> iTypes;
+        std::unordered_map<std::string, const i_concept*> iOwners;
+        concept_type_id iNextType;
+        uint32_t iNextPosition;
+    };
+}
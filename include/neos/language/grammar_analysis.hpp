@@ -0,0 +1,67 @@
+/*
+  grammar_analysis.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include <neos/language/i_schema_node_atom.hpp>
+
+namespace neos::language
+{
+    // Static analysis of a built schema for rules that make the parser backtrack heavily. Warnings are ranked, 
+    // most expensive first: by kind, then by how many alternatives or characters are affected.
+    class grammar_analysis
+    {
+    public:
+        enum class finding : uint32_t
+        {
+            LeftRecursion,
+            UnboundedLoop,
+            ShadowingDefault,
+            OverlappingAlternatives
+        };
+        struct warning
+        {
+            finding kind;
+            std::size_t weight;
+            std::string text;
+        };
+        typedef std::vector<warning> warnings_t;
+        // adds the source location of the definition (a node atom or a token entry) a warning refers to
+        typedef std::function<std::string(const void*, const std::string&)> locator_t;
+    public:
+        grammar_analysis(const std::vector<i_schema_node_atom*>& aNodes, const locator_t& aLocator = {});
+        // the ranked warnings of an earlier analysis, as stored in a schema image
+        grammar_analysis(const warnings_t& aWarnings);
+    public:
+        const warnings_t& warnings() const;
+    private:
+        void find_left_recursion(const std::vector<i_schema_node_atom*>& aNodes);
+        void find_unbounded_loops(const std::vector<i_schema_node_atom*>& aNodes);
+        void find_shadowing_defaults(const std::vector<i_schema_node_atom*>& aNodes);
+        void find_overlapping_alternatives(const std::vector<i_schema_node_atom*>& aNodes);
+        void add(finding aKind, std::size_t aWeight, const void* aDefinition, const std::string& aText);
+    private:
+        locator_t iLocator;
+        warnings_t iWarnings;
+    };
+}
@@ -0,0 +1,48 @@
+/*
+  hierarchy_interval.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+
+namespace neos::language
+{
+    // Euler tour position of a node in a frozen hierarchy: its pre-order index and one past the 
+    // pre-order index of its last descendant, so ancestry is two integer comparisons.
+    struct hierarchy_interval
+    {
+        static constexpr uint32_t Unfrozen = 0xFFFFFFFFu;
+
+        uint32_t first = Unfrozen;
+        uint32_t last = Unfrozen;
+
+        bool frozen() const
+        {
+            return first != Unfrozen;
+        }
+        bool contains(const hierarchy_interval& aOther) const
+        {
+            return aOther.first >= first && aOther.first < last;
+        }
+        bool is_ancestor_of(const hierarchy_interval& aOther) const
+        {
+            return aOther.first > first && aOther.first < last;
+        }
+    };
+}
@@ -0,0 +1,45 @@
+/*
+  i_concept_library_manifest.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <neolib/core/i_discoverable.hpp>
+#include <neolib/core/i_string.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        // What a concept library plugin provides, discoverable without instantiating its libraries: the names 
+        // of its libraries and the concept namespaces (e.g. "math" for "math.expression") its concepts are in.
+        class i_concept_library_manifest : public neolib::i_reference_counted
+        {
+        public:
+            typedef i_concept_library_manifest abstract_type;
+        public:
+            virtual const neolib::i_string& library_name() const = 0;
+            virtual bool provides(const neolib::i_string& aLibraryName) const = 0;
+            virtual uint32_t concept_namespace_count() const = 0;
+            virtual const neolib::i_string& concept_namespace(uint32_t aIndex) const = 0;
+        public:
+            static const neolib::uuid& iid() { static neolib::uuid sId = neolib::make_uuid("5E0B3A9C-7F4D-4A61-9C2E-0D8B6F1A3C57"); return sId; }
+        };
+    }
+}
@@ -0,0 +1,41 @@
+/*
+  i_concept_provider.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <string>
+#include <neolib/core/reference_counted.hpp>
+#include <neos/language/i_concept.hpp>
+
+namespace neos::language
+{
+    // Where a schema gets its concept libraries and concepts from. Libraries may be instantiated on demand: 
+    // find_concept() only searches libraries already instantiated whereas require_concept() instantiates 
+    // further libraries until the concept is found.
+    class i_concept_provider
+    {
+    public:
+        virtual ~i_concept_provider() = default;
+    public:
+        virtual bool require_library(const std::string& aLibraryName) = 0;
+        virtual neolib::ref_ptr<i_concept> find_concept(const std::string& aSymbol) const = 0;
+        virtual neolib::ref_ptr<i_concept> require_concept(const std::string& aSymbol) = 0;
+    };
+}
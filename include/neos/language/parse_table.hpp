@@ -0,0 +1,73 @@
+/*
+  parse_table.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <array>
+#include <unordered_map>
+#include <neos/language/character_set.hpp>
+#include <neos/language/character_scanner.hpp>
+#include <neos/language/i_schema_node_atom.hpp>
+
+namespace neos::language
+{
+    // Flat LL(1) lowering of a schema: for every node the token alternatives in document order 
+    // together with a byte indexed prediction of which alternative can start at the current source.
+    class parse_table
+    {
+    public:
+        typedef uint16_t alternative_index;
+        static constexpr alternative_index NoAlternative = 0xFFFFu;
+        static constexpr alternative_index Ambiguous = 0xFFFEu;
+    public:
+        struct alternative
+        {
+            const i_atom* key;
+            const i_atom* value;
+            character_set first;
+        };
+        struct node
+        {
+            const i_schema_node_atom* atom;
+            std::size_t firstAlternative;
+            alternative_index alternativeCount;
+            bool deterministic;
+            std::array<alternative_index, 256> prediction;
+            std::array<alternative_index, 256> candidate; // first alternative that can start with the character
+            character_scanner run; // characters whose candidate is a single character class that continues the node
+        };
+        typedef std::vector<node> nodes_t;
+        typedef std::vector<alternative> alternatives_t;
+    public:
+        parse_table(const std::vector<i_schema_node_atom*>& aNodes);
+    public:
+        const node* find(const i_schema_node_atom& aAtom) const;
+        const i_atom& predict(const node& aNode, char aCharacter) const;
+        const i_atom& candidate(const node& aNode, char aCharacter) const;
+        const nodes_t& nodes() const;
+        std::size_t deterministic_nodes() const;
+    private:
+        void compute_runs(node& aNode) const;
+    private:
+        nodes_t iNodes;
+        alternatives_t iAlternatives;
+        std::unordered_map<const i_schema_node_atom*, std::size_t> iIndex;
+    };
+}
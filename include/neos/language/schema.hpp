@@ -1,132 +1,155 @@
-/*
-  schema.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neos/neos.hpp>
-#include <boost/functional/hash.hpp>
-#include <neolib/core/i_map.hpp>
-#include <neolib/core/i_string.hpp>
-#include <neolib/file/json.hpp>
-#include <neos/language/i_concept_library.hpp>
-#include <neos/language/schema_node_atom.hpp>
-#include <neos/language/schema_terminal_atom.hpp>
-#include <neos/language/concept_atom.hpp>
-
-namespace neos
-{
-    namespace language
-    {
-        struct meta
-        {
-            std::string name;
-            std::string description;
-            std::string copyright;
-            std::string version;
-            std::vector<std::string> sourcecodeFileExtension;
-            std::vector<std::string> sourcecodeModulePackageSpecificationFileExtension;
-            std::vector<std::string> sourcecodeModulePackageImplementationFileExtension;
-            std::size_t parserRecursionLimit = 256u;
-        };
-
-        enum class schema_keyword
-        {
-            Invalid,
-            Meta,
-            Libraries,
-            Is,
-            As,
-            Done,
-            Drain,
-            Next,
-            Continue,
-            Ignore,
-            None,
-            Error,
-            Default,
-            Expect,
-            Tokens
-        };
-
-        class schema
-        {
-        public:
-            typedef neolib::i_ref_ptr<i_atom> abstract_atom_ptr;
-            typedef neolib::ref_ptr<i_atom> atom_ptr;
-            typedef std::pair<neolib::rjson_string, std::string> atom_reference_key_t;
-            struct atom_reference
-            {
-                neolib::rjson_value const* node;
-                abstract_atom_ptr* atomPtr;
-            };
-            typedef std::vector<atom_reference> unresolved_reference_list;
-            typedef std::unordered_map<atom_reference_key_t, unresolved_reference_list, boost::hash<atom_reference_key_t>> atom_references_t;
-        public:
-            struct unresolved_references : std::runtime_error
-            {
-                unresolved_reference_list references;
-                unresolved_references(unresolved_reference_list&& aReferences) :
-                    std::runtime_error("neos::language::schema::unresolved_references"),
-                    references{ std::move(aReferences) }
-                {}
-            };
-        private:
-            typedef std::function<void(neolib::rjson_value const&, i_schema_node_atom&)> atom_handler_t;
-            typedef std::map<schema_keyword, atom_handler_t> atom_handlers_t;
-            typedef std::unordered_map<const i_concept*, atom_ptr> concept_atoms_t;
-        public:
-            static constexpr std::size_t RecursionLimit = 64u;
-        public:
-            schema(neolib::rjson const& aSource, const concept_libraries_t& aConceptLibraries);
-        public:
-            i_schema_node_atom& root() const;
-            language::meta const& meta() const;
-            neolib::ref_ptr<i_concept> find_concept(const std::string& aSymbol) const;
-        private:
-            static schema_keyword keyword(const neolib::rjson_string& aSymbol);
-            void default_atom_handler(neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom);
-            atom_handlers_t& atom_handlers();
-            void parse(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom);
-            void parse_meta(neolib::rjson_value const& aNode);
-            void parse_tokens(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom);
-            std::string fully_qualified_name(neolib::rjson_value const& aNode) const;
-            std::string fully_qualified_name(neolib::rjson_value const& aNode, const neolib::rjson_string& aLeafName) const;
-            const atom_references_t& atom_references() const;
-            atom_references_t& atom_references();
-            void add_lhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom);
-            void add_rhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom);
-            void resolve_references();
-            std::string fully_qualified_name(const i_atom& aAtom) const;
-            atom_ptr leaf(const std::string& aStem, const neolib::rjson_string& aLeafName);
-            atom_ptr leaf(i_schema_node_atom& aNode, const std::string& aStem, const neolib::rjson_string& aLeafName);
-            atom_ptr create_concept_atom(const neolib::i_ref_ptr<i_concept>& aConcept);
-            void throw_error(neolib::rjson_value const& aNode, const std::string aErrorText);
-        private:
-            neolib::rjson const& iSource;
-            std::optional<atom_handler_t> iDefaultAtomHandler;
-            std::optional<atom_handlers_t> iAtomHandlers;
-            language::meta iMeta;
-            const concept_libraries_t& iConceptLibraries;
-            atom_ptr iRoot;
-            atom_references_t iAtomReferences;
-            concept_atoms_t iConceptAtoms;
-            bool iParsingTokens;
-        };
-    }
+/*
+  schema.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <boost/functional/hash.hpp>
+#include <neolib/core/i_map.hpp>
+#include <neolib/core/i_string.hpp>
+#include <neolib/file/json.hpp>
+#include <neos/language/i_concept_library.hpp>
+#include <neos/language/i_concept_provider.hpp>
+#include <neos/language/schema_node_atom.hpp>
+#include <neos/language/schema_terminal_atom.hpp>
+#include <neos/language/concept_atom.hpp>
+#include <neos/language/parse_table.hpp>
+#include <neos/language/grammar_analysis.hpp>
+#include <neos/language/schema_image.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        struct meta
+        {
+            std::string name;
+            std::string description;
+            std::string copyright;
+            std::string version;
+            std::vector<std::string> sourcecodeFileExtension;
+            std::vector<std::string> sourcecodeModulePackageSpecificationFileExtension;
+            std::vector<std::string> sourcecodeModulePackageImplementationFileExtension;
+            std::vector<std::string> libraries;
+            std::size_t parserRecursionLimit = 256u;
+        };
+
+        enum class schema_keyword
+        {
+            Invalid,
+            Meta,
+            Libraries,
+            Is,
+            As,
+            Done,
+            Drain,
+            Next,
+            Continue,
+            Ignore,
+            None,
+            Error,
+            Default,
+            Expect,
+            Tokens
+        };
+
+        class schema
+        {
+        public:
+            typedef neolib::i_ref_ptr<i_atom> abstract_atom_ptr;
+            typedef neolib::ref_ptr<i_atom> atom_ptr;
+            typedef std::pair<neolib::rjson_string, std::string> atom_reference_key_t;
+            struct atom_reference
+            {
+                neolib::rjson_value const* node;
+                abstract_atom_ptr* atomPtr;
+            };
+            typedef std::vector<atom_reference> unresolved_reference_list;
+            typedef std::unordered_map<atom_reference_key_t, unresolved_reference_list, boost::hash<atom_reference_key_t>> atom_references_t;
+        public:
+            struct unresolved_references : std::runtime_error
+            {
+                unresolved_reference_list references;
+                unresolved_references(unresolved_reference_list&& aReferences) :
+                    std::runtime_error("neos::language::schema::unresolved_references"),
+                    references{ std::move(aReferences) }
+                {}
+            };
+        private:
+            typedef std::function<void(neolib::rjson_value const&, i_schema_node_atom&)> atom_handler_t;
+            typedef std::map<schema_keyword, atom_handler_t> atom_handlers_t;
+            typedef std::unordered_map<const i_concept*, atom_ptr> concept_atoms_t;
+            typedef std::unordered_map<i_schema_node_atom*, std::optional<character_set>> first_characters_t;
+            typedef std::unordered_map<std::string, i_schema_node_atom*> node_index_t;
+            typedef std::unordered_map<const void*, neolib::rjson_value const*> definitions_t;
+        public:
+            static constexpr std::size_t RecursionLimit = 64u;
+        public:
+            schema(neolib::rjson const& aSource, i_concept_provider& aConcepts);
+            schema(schema_image& aImage, i_concept_provider& aConcepts);
+        public:
+            i_schema_node_atom& root() const;
+            language::meta const& meta() const;
+            language::parse_table const& parse_table() const;
+            language::grammar_analysis const& analysis() const;
+            neolib::ref_ptr<i_concept> find_concept(const std::string& aSymbol) const;
+            void save_image(const std::string& aPath, const schema_image::version_stamp& aStamp) const;
+        private:
+            static schema_keyword keyword(const neolib::rjson_string& aSymbol);
+            void default_atom_handler(neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom);
+            atom_handlers_t& atom_handlers();
+            void parse(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom);
+            void parse_meta(neolib::rjson_value const& aNode);
+            void parse_tokens(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom);
+            std::string fully_qualified_name(neolib::rjson_value const& aNode) const;
+            std::string fully_qualified_name(neolib::rjson_value const& aNode, const neolib::rjson_string& aLeafName) const;
+            const atom_references_t& atom_references() const;
+            atom_references_t& atom_references();
+            void add_lhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom);
+            void add_rhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom);
+            void index_nodes();
+            neolib::ref_ptr<i_concept> require_concept(const std::string& aSymbol) const;
+            void resolve_references();
+            void compute_first_characters();
+            void freeze_hierarchy();
+            void read_image(schema_image& aImage);
+            void create_parse_table();
+            void analyze();
+            character_set first_characters(i_atom& aAtom, first_characters_t& aFirstCharacters);
+            atom_ptr leaf(const std::string& aStem, const neolib::rjson_string& aLeafName);
+            atom_ptr create_concept_atom(const neolib::i_ref_ptr<i_concept>& aConcept);
+            void throw_error(neolib::rjson_value const& aNode, const std::string aErrorText);
+        private:
+            neolib::rjson const* iSource;
+            std::optional<atom_handler_t> iDefaultAtomHandler;
+            std::optional<atom_handlers_t> iAtomHandlers;
+            language::meta iMeta;
+            i_concept_provider& iConcepts;
+            atom_ptr iRoot;
+            atom_references_t iAtomReferences;
+            concept_atoms_t iConceptAtoms;
+            node_index_t iNodeIndex;
+            std::vector<i_schema_node_atom*> iNodes;
+            std::optional<language::parse_table> iParseTable;
+            definitions_t iDefinitions;
+            std::optional<language::grammar_analysis> iAnalysis;
+            bool iParsingTokens;
+        };
+    }
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+/*
+  schema_image.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <cstring>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <neos/language/i_concept_library.hpp>
+
+namespace neos::language
+{
+    // 64-bit FNV-1a, used for image stamps
+    class fnv1a
+    {
+    public:
+        void add(const char* aData, std::size_t aLength)
+        {
+            for (std::size_t i = 0u; i < aLength; ++i)
+            {
+                iHash ^= static_cast<unsigned char>(aData[i]);
+                iHash *= 0x100000001b3ull;
+            }
+        }
+        void add(const std::string& aString)
+        {
+            add(aString.data(), aString.size());
+            add("\0", 1u);
+        }
+        uint64_t hash() const
+        {
+            return iHash;
+        }
+    private:
+        uint64_t iHash = 0xcbf29ce484222325ull;
+    };
+
+    // Versioned binary image of a resolved schema. The image is stamped with a hash of the schema 
+    // source and of the discovered concept library plugin versions; a stamp mismatch means the image is stale. 
+    // Images live in a cache directory, named by a hash of the absolute source path, not beside their source.
+    class schema_image
+    {
+    public:
+        struct bad_image : std::runtime_error { bad_image() : std::runtime_error("neos::language::schema_image::bad_image") {} };
+    public:
+        struct version_stamp
+        {
+            uint64_t source = 0ull;
+            uint64_t libraries = 0ull;
+
+            bool operator==(const version_stamp& aOther) const
+            {
+                return source == aOther.source && libraries == aOther.libraries;
+            }
+            bool operator!=(const version_stamp& aOther) const
+            {
+                return !(*this == aOther);
+            }
+        };
+        typedef uint32_t atom_index;
+        enum class atom_kind : uint8_t
+        {
+            SchemaNode,
+            SchemaTerminal,
+            Concept
+        };
+    public:
+        static constexpr uint32_t FormatVersion = 3u;
+        static constexpr atom_index NoAtom = 0xFFFFFFFFu;
+    public:
+        schema_image(const std::string& aPath);
+    public:
+        static std::string default_cache_directory();
+        static std::string path(const std::string& aCacheDirectory, const std::string& aSourcePath);
+        static version_stamp compute_stamp(const std::string& aSourcePath, const std::string& aPluginsFingerprint);
+    public:
+        const version_stamp& stamp() const;
+        template <typename T>
+        T read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (static_cast<std::size_t>(iEnd - iCursor) < sizeof(T))
+                throw bad_image();
+            T result;
+            std::memcpy(&result, iCursor, sizeof(T));
+            iCursor += sizeof(T);
+            return result;
+        }
+        std::string read_string();
+    private:
+        boost::interprocess::file_mapping iFile;
+        boost::interprocess::mapped_region iRegion;
+        const char* iCursor;
+        const char* iEnd;
+        version_stamp iStamp;
+    };
+
+    class schema_image_writer
+    {
+    public:
+        schema_image_writer(const schema_image::version_stamp& aStamp);
+    public:
+        template <typename T>
+        void write(const T& aValue)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto const bytes = reinterpret_cast<const char*>(&aValue);
+            iBuffer.insert(iBuffer.end(), bytes, bytes + sizeof(T));
+        }
+        void write_string(const std::string& aString);
+        void save(const std::string& aPath) const;
+    private:
+        std::vector<char> iBuffer;
+    };
+}
@@ -0,0 +1,37 @@
+/*
+  static_concept_libraries.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <vector>
+#include <neolib/core/reference_counted.hpp>
+#include <neolib/plugin/i_plugin.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        // Defining NEOS_STATIC_CORE_CONCEPTS links the core concept libraries into neos itself; they are then 
+        // registered without loading their plugin modules and calls into them need not cross a module boundary. 
+        // The ReleaseStatic configuration of the neos project defines it.
+        bool static_core_concepts();
+        void static_concept_library_plugins(std::vector<neolib::ref_ptr<neolib::i_plugin>>& aPlugins);
+    }
+}
@@ -1,40 +1,96 @@
-/*
-  symbols.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neos/neos.hpp>
-#include <string>
-#include <map>
-
-namespace neos
-{
-    namespace language
-    {
-        enum class symbol_type : uint32_t
-        {
-            Function,
-            Data
-        };
-        typedef std::string symbol_name_t;
-        typedef std::pair<symbol_type, symbol_name_t> symbol_key_t;
-        typedef void const* symbol_reference_t;
-        typedef std::map<symbol_key_t, symbol_reference_t> symbol_table_t;
-    }
-}
\ No newline at end of file
+/*
+  symbols.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace neos
+{
+    namespace language
+    {
+        enum class symbol_type : uint32_t
+        {
+            Function,
+            Data
+        };
+        typedef std::string symbol_name_t;
+        typedef uint32_t symbol_handle_t;
+        typedef void const* symbol_reference_t;
+
+        // Symbol names are interned once into a string pool shared by every translation unit of a program and are 
+        // referred to by handle from then on; definitions are found by hashing (type, handle) in an open 
+        // addressing table so lookups never compare strings.
+        class symbol_table
+        {
+        public:
+            static constexpr symbol_handle_t NoSymbol = 0xFFFFFFFFu;
+            struct key
+            {
+                symbol_type type;
+                symbol_handle_t name;
+            };
+        private:
+            struct name_entry
+            {
+                uint32_t offset;
+                uint32_t length;
+                std::size_t hash;
+            };
+            struct definition
+            {
+                key symbol;
+                symbol_reference_t reference;
+            };
+        public:
+            symbol_table();
+        public:
+            symbol_handle_t intern(std::string_view aName);
+            symbol_handle_t find(std::string_view aName) const;
+            // the view is invalidated by the next intern()
+            std::string_view name(symbol_handle_t aSymbol) const;
+            std::size_t names() const;
+        public:
+            void define(const key& aKey, symbol_reference_t aReference);
+            const symbol_reference_t* find(const key& aKey) const;
+            const symbol_reference_t* find(symbol_type aType, std::string_view aName) const;
+            std::size_t size() const;
+            void clear();
+        private:
+            void reserve_names(std::size_t aNames);
+            void reserve_definitions(std::size_t aDefinitions);
+            uint32_t& find_name_slot(std::size_t aHash, std::string_view aName);
+            definition& find_definition_slot(const key& aKey);
+            static std::size_t hash(const key& aKey);
+        private:
+            std::string iPool;
+            std::vector<name_entry> iNames;
+            std::vector<uint32_t> iNameSlots;
+            std::size_t iNameMask;
+            std::vector<definition> iDefinitions;
+            std::size_t iDefinitionMask;
+            std::size_t iDefinitionCount;
+        };
+
+        typedef symbol_table symbol_table_t;
+    }
+}
@@ -1,31 +1,31 @@
-/*
-  neos.hpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#pragma once
-
-#include <neolib/neolib.hpp>
-#include <vector>
-#include <neolib/app/version.hpp>
-
-namespace neos
-{
-    const neolib::version NEOS_VERSION = { 1u, 0u, 0u, 0u, "ED-209"};
-
-    typedef std::vector<std::byte> text_t;
+/*
+  neos.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <vector>
+#include <neolib/app/version.hpp>
+
+namespace neos
+{
+    const neolib::version NEOS_VERSION = { 1u, 0u, 0u, 0u, "ED-209"};
+
+    typedef std::vector<std::byte> text_t;
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+  shared_registry.hpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neos/neos.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <neolib/core/map.hpp>
+#include <neolib/core/string.hpp>
+#include <neolib/app/i_application.hpp>
+#include <neolib/plugin/i_plugin.hpp>
+#include <neos/language/i_concept_library_manifest.hpp>
+#include <neos/language/i_concept_provider.hpp>
+#include <neos/language/concept_type_registry.hpp>
+#include <neos/language/concept_index.hpp>
+#include <neos/language/schema.hpp>
+
+namespace neos
+{
+    // The concept library plugins found by the plugin manager, the libraries instantiated from them so far 
+    // with their concept index and concept types, plus a cache of the schemas built against them keyed by 
+    // source path and source hash. A plugin's libraries are instantiated when a schema names one of them or a 
+    // concept lookup names a concept in a namespace its manifest claims, together with those of every plugin 
+    // claiming an overlapping namespace. Contexts share one process-wide registry unless given their own application.
+    class shared_registry : public language::i_concept_provider
+    {
+    public:
+        typedef neolib::map<neolib::string, neolib::ref_ptr<language::i_concept_library>> concept_libraries_t;
+    public:
+        shared_registry();
+        shared_registry(neolib::i_application& aApplication);
+        ~shared_registry();
+    public:
+        static std::shared_ptr<shared_registry> instance();
+    public:
+        concept_libraries_t concept_libraries() const;
+        const language::concept_type_registry& concept_types() const;
+        const std::string& plugins_fingerprint() const;
+    public:
+        bool require_library(const std::string& aLibraryName) override;
+        neolib::ref_ptr<language::i_concept> find_concept(const std::string& aSymbol) const override;
+        neolib::ref_ptr<language::i_concept> require_concept(const std::string& aSymbol) override;
+    public:
+        std::shared_ptr<const language::schema> cached_schema(const std::string& aSourcePath, uint64_t aSourceHash) const;
+        void cache_schema(const std::string& aSourcePath, uint64_t aSourceHash, const std::shared_ptr<const language::schema>& aSchema);
+    private:
+        struct plugin_entry
+        {
+            neolib::ref_ptr<neolib::i_plugin> plugin;
+            neolib::ref_ptr<language::i_concept_library_manifest> manifest;
+            std::vector<std::string> conceptNamespaces;
+            bool instantiated;
+        };
+        typedef std::pair<std::string, uint64_t> schema_key;
+        typedef std::map<schema_key, std::shared_ptr<const language::schema>> schema_cache;
+    private:
+        void discover_plugins();
+        void instantiate(plugin_entry& aPlugin);
+    private:
+        std::unique_ptr<neolib::i_application> iPrivateApplication;
+        neolib::i_application& iApplication;
+        mutable std::shared_mutex iLibrariesMutex;
+        std::vector<plugin_entry> iPlugins;
+        std::string iPluginsFingerprint;
+        concept_libraries_t iConceptLibraries;
+        language::concept_type_registry iConceptTypes;
+        language::concept_index iConcepts;
+        mutable std::mutex iSchemasMutex;
+        schema_cache iSchemas;
+    };
+}
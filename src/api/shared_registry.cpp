@@ -0,0 +1,235 @@
+/*
+  shared_registry.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <neolib/app/application.hpp>
+#include <neos/language/static_concept_libraries.hpp>
+#include <neos/shared_registry.hpp>
+
+namespace neos
+{
+    namespace
+    {
+        std::string schema_cache_path(const std::string& aSourcePath)
+        {
+            return boost::filesystem::absolute(aSourcePath).lexically_normal().string();
+        }
+
+        bool within_namespace(const std::string& aName, const std::string& aNamespace)
+        {
+            return aName == aNamespace || (aName.size() > aNamespace.size() && aName[aNamespace.size()] == '.' && aName.compare(0u, aNamespace.size(), aNamespace) == 0);
+        }
+
+        bool claims(const std::vector<std::string>& aNamespaces, const std::string& aName)
+        {
+            return std::any_of(aNamespaces.begin(), aNamespaces.end(), [&](auto const& aNamespace) { return within_namespace(aName, aNamespace); });
+        }
+
+        bool overlap(const std::vector<std::string>& aNamespaces, const std::vector<std::string>& aOtherNamespaces)
+        {
+            return std::any_of(aNamespaces.begin(), aNamespaces.end(), [&](auto const& aNamespace) 
+            { 
+                return claims(aOtherNamespaces, aNamespace) || std::any_of(aOtherNamespaces.begin(), aOtherNamespaces.end(), [&](auto const& aOther) { return within_namespace(aOther, aNamespace); });
+            });
+        }
+    }
+
+    shared_registry::shared_registry() :
+        iPrivateApplication{ std::make_unique<neolib::application<>>(neolib::application_info{ "neos", "i42 software", {}, "Copyright (c) 2019 Leigh Johnston", {}, {}, {}, ".ncl" }) },
+        iApplication{ *iPrivateApplication }
+    {
+        discover_plugins();
+    }
+
+    shared_registry::shared_registry(neolib::i_application& aApplication) :
+        iApplication{ aApplication }
+    {
+        iApplication.plugin_manager().plugin_file_extensions().clear();
+        iApplication.plugin_manager().plugin_file_extensions().push_back(neolib::string{ ".ncl" });
+        discover_plugins();
+    }
+
+    shared_registry::~shared_registry()
+    {
+        // cached schemas refer to the concept libraries so must go first
+        iSchemas.clear();
+    }
+
+    std::shared_ptr<shared_registry> shared_registry::instance()
+    {
+        static auto const sInstance = std::make_shared<shared_registry>();
+        return sInstance;
+    }
+
+    shared_registry::concept_libraries_t shared_registry::concept_libraries() const
+    {
+        // a copy: libraries are instantiated on demand by any context sharing the registry
+        std::shared_lock<std::shared_mutex> lock{ iLibrariesMutex };
+        return iConceptLibraries;
+    }
+
+    const language::concept_type_registry& shared_registry::concept_types() const
+    {
+        return iConceptTypes;
+    }
+
+    const std::string& shared_registry::plugins_fingerprint() const
+    {
+        return iPluginsFingerprint;
+    }
+
+    bool shared_registry::require_library(const std::string& aLibraryName)
+    {
+        neolib::string const name{ aLibraryName };
+        {
+            std::shared_lock<std::shared_mutex> lock{ iLibrariesMutex };
+            if (iConceptLibraries.find(name) != iConceptLibraries.end())
+                return true;
+        }
+        std::unique_lock<std::shared_mutex> lock{ iLibrariesMutex };
+        for (auto& p : iPlugins)
+            if (!p.instantiated && p.manifest != nullptr && p.manifest->provides(name))
+            {
+                instantiate(p);
+                break;
+            }
+        return iConceptLibraries.find(name) != iConceptLibraries.end();
+    }
+
+    neolib::ref_ptr<language::i_concept> shared_registry::find_concept(const std::string& aSymbol) const
+    {
+        std::shared_lock<std::shared_mutex> lock{ iLibrariesMutex };
+        return iConcepts.find(aSymbol);
+    }
+
+    neolib::ref_ptr<language::i_concept> shared_registry::require_concept(const std::string& aSymbol)
+    {
+        auto result = find_concept(aSymbol);
+        if (result != nullptr)
+            return result;
+        std::unique_lock<std::shared_mutex> lock{ iLibrariesMutex };
+        // every plugin whose manifest claims the name is instantiated so that a name defined by two libraries 
+        // is ambiguous rather than resolved by whichever was instantiated first
+        for (auto& p : iPlugins)
+            if (!p.instantiated && claims(p.conceptNamespaces, aSymbol))
+                instantiate(p);
+        return iConcepts.find(aSymbol);
+    }
+
+    std::shared_ptr<const language::schema> shared_registry::cached_schema(const std::string& aSourcePath, uint64_t aSourceHash) const
+    {
+        std::lock_guard<std::mutex> lg{ iSchemasMutex };
+        auto existing = iSchemas.find(schema_key{ schema_cache_path(aSourcePath), aSourceHash });
+        if (existing != iSchemas.end())
+            return existing->second;
+        return nullptr;
+    }
+
+    void shared_registry::cache_schema(const std::string& aSourcePath, uint64_t aSourceHash, const std::shared_ptr<const language::schema>& aSchema)
+    {
+        std::lock_guard<std::mutex> lg{ iSchemasMutex };
+        auto const path = schema_cache_path(aSourcePath);
+        // a changed source replaces the schema cached for its previous contents
+        for (auto existing = iSchemas.begin(); existing != iSchemas.end();)
+            if (existing->first.first == path && existing->first.second != aSourceHash)
+                existing = iSchemas.erase(existing);
+            else
+                ++existing;
+        iSchemas[schema_key{ path, aSourceHash }] = aSchema;
+    }
+
+    void shared_registry::discover_plugins()
+    {
+        // loading a plugin only creates its plugin object; its concept libraries are instantiated later, on demand
+        std::vector<neolib::ref_ptr<neolib::i_plugin>> plugins;
+        language::static_concept_library_plugins(plugins);
+        iApplication.plugin_manager().load_plugins();
+        // a plugin module of a concept library linked in statically is ignored
+        for (neolib::ref_ptr<neolib::i_plugin> p : iApplication.plugin_manager().plugins())
+            if (std::none_of(plugins.begin(), plugins.end(), [&](auto const& existing) { return existing->id() == p->id(); }))
+                plugins.push_back(p);
+        std::ostringstream fingerprint;
+        for (auto const& p : plugins)
+        {
+            iPlugins.push_back(plugin_entry{ p, {}, false });
+            void* manifest = nullptr;
+            if (p->discover(language::i_concept_library_manifest::iid(), manifest))
+            {
+                iPlugins.back().manifest = neolib::ref_ptr<language::i_concept_library_manifest>{ static_cast<language::i_concept_library_manifest*>(manifest) };
+                for (uint32_t i = 0u; i < iPlugins.back().manifest->concept_namespace_count(); ++i)
+                    iPlugins.back().conceptNamespaces.push_back(iPlugins.back().manifest->concept_namespace(i).to_std_string());
+            }
+            fingerprint << p->name().to_std_string() << ' ' << p->version() << '\n';
+        }
+        iPluginsFingerprint = fingerprint.str();
+        // plugins without a manifest cannot say what they provide so are instantiated now
+        for (auto& p : iPlugins)
+            if (p.manifest == nullptr)
+                instantiate(p);
+    }
+
+    void shared_registry::instantiate(plugin_entry& aPlugin)
+    {
+        // plugins claiming overlapping concept namespaces are instantiated together, as one batch of concept types, 
+        // so that both sides of any name collision are present before either can be looked up
+        std::vector<plugin_entry*> batch{ &aPlugin };
+        aPlugin.instantiated = true;
+        for (std::size_t i = 0u; i < batch.size(); ++i)
+            for (auto& p : iPlugins)
+                if (!p.instantiated && overlap(batch[i]->conceptNamespaces, p.conceptNamespaces))
+                {
+                    p.instantiated = true;
+                    batch.push_back(&p);
+                }
+        auto const existingCollisions = iConcepts.collisions().size();
+        concept_libraries_t added;
+        auto add_library = [&added](auto& self, const neolib::i_string& aName, const neolib::i_ref_ptr<language::i_concept_library>& aLibrary) -> void
+        {
+            added[aName] = aLibrary;
+            for (auto& sublibrary : aLibrary->sublibraries())
+                self(self, sublibrary.first(), sublibrary.second());
+        };
+        for (auto p : batch)
+        {
+            void* discovered = nullptr;
+            if (!p->plugin->discover(language::i_concept_library::iid(), discovered))
+            {
+                std::cerr << "Warning: plugin '" << p->plugin->name().to_std_string() << "' does not provide this version of the concept library interface; ignored" << std::endl;
+                continue;
+            }
+            neolib::ref_ptr<language::i_concept_library> library{ static_cast<language::i_concept_library*>(discovered) };
+            add_library(add_library, library->name(), library);
+        }
+        // concept types only append so the new concepts are typed before they can be found and the concepts 
+        // of libraries instantiated earlier, which other contexts may be reading, are left untouched
+        iConceptTypes.register_types(added);
+        for (auto const& newLibrary : added)
+        {
+            iConceptLibraries[newLibrary.first()] = newLibrary.second();
+            iConcepts.add(*newLibrary.second());
+        }
+        for (auto collision = std::next(iConcepts.collisions().begin(), existingCollisions); collision != iConcepts.collisions().end(); ++collision)
+            std::cerr << "Warning: concept '" << collision->name << "' is defined by both concept library '" << collision->library << 
+                "' and concept library '" << collision->otherLibrary << "'; the name is ambiguous and will not resolve" << std::endl;
+    }
+}
@@ -0,0 +1,199 @@
+/*
+  ast.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <neos/language/ast.hpp>
+
+namespace neos::language
+{
+    ast::ast(symbol_table_t& aSymbolTable) : 
+        iSymbolTable{ aSymbolTable }
+    {
+    }
+
+    ast::ast(ast const& aOther) : 
+        iSymbolTable{ aOther.iSymbolTable }, 
+        iNodes{ aOther.iNodes }, 
+        iPending{ aOther.iPending }, 
+        iConcepts{ aOther.iConcepts }, 
+        iIdentifiers{ aOther.iIdentifiers }, 
+        iConceptIds{ aOther.iConceptIds }, 
+        iFragments{ aOther.iFragments }
+    {
+    }
+
+    ast& ast::operator=(ast const& aOther)
+    {
+        if (&aOther == this)
+            return *this;
+        this->~ast();
+        new (this) ast{ aOther };
+        return *this;
+    }
+
+    bool ast::empty() const
+    {
+        return iNodes.empty();
+    }
+
+    std::size_t ast::size() const
+    {
+        return iNodes.size();
+    }
+
+    const ast::nodes_t& ast::nodes() const
+    {
+        return iNodes;
+    }
+
+    const ast::node& ast::operator[](node_index aIndex) const
+    {
+        return iNodes[aIndex];
+    }
+
+    ast::children_range ast::children(node_index aIndex) const
+    {
+        return children_range{ iNodes, aIndex };
+    }
+
+    const i_concept& ast::concept_of(concept_id aKind) const
+    {
+        return *iConcepts[aKind];
+    }
+
+    const i_source_fragment& ast::fragment_of(fragment_id aFragment) const
+    {
+        return *iFragments[aFragment];
+    }
+
+    const symbol_table_t& ast::symbols() const
+    {
+        return iSymbolTable;
+    }
+
+    std::size_t ast::memory_usage() const
+    {
+        return iNodes.capacity() * sizeof(node) + iPending.capacity() * sizeof(pending_node) +
+            iConcepts.capacity() * sizeof(const i_concept*) + iIdentifiers.capacity() / 8u + iConceptIds.size() * (sizeof(const i_concept*) + sizeof(concept_id)) + 
+            iFragments.capacity() * sizeof(const i_source_fragment*);
+    }
+
+    ast::node_index ast::add(const i_concept& aConcept, const i_source_fragment& aFragment, uint32_t aFirst, uint32_t aLast)
+    {
+        iPending.push_back(pending_node{ intern(aConcept), None, None, None, source_span{ intern(aFragment), aFirst, aLast }, symbol_table::NoSymbol });
+        return static_cast<node_index>(iPending.size() - 1u);
+    }
+
+    void ast::adopt(node_index aParent, node_index aChild)
+    {
+        auto& parent = iPending[aParent];
+        auto& child = iPending[aChild];
+        child.parent = aParent;
+        // children are kept in source order whatever order they are folded in
+        auto next = &parent.firstChild;
+        while (*next != None && iPending[*next].source.first <= child.source.first)
+            next = &iPending[*next].nextSibling;
+        child.nextSibling = *next;
+        *next = aChild;
+        if (child.source.fragment == parent.source.fragment)
+        {
+            parent.source.first = std::min(parent.source.first, child.source.first);
+            parent.source.last = std::max(parent.source.last, child.source.last);
+        }
+    }
+
+    void ast::resolve(node_index aNode, const i_concept& aInstance)
+    {
+        auto& pending = iPending[aNode];
+        if (iIdentifiers[pending.kind] && pending.symbol == symbol_table::NoSymbol)
+            pending.symbol = iSymbolTable.intern(aInstance.data<neolib::i_string>().to_std_string_view());
+    }
+
+    void ast::compact()
+    {
+        if (iPending.empty())
+            return;
+        auto const base = static_cast<node_index>(iNodes.size());
+        std::vector<node_index> order;
+        std::vector<node_index> position(iPending.size());
+        order.reserve(iPending.size());
+        std::vector<node_index> work;
+        for (node_index root = static_cast<node_index>(iPending.size()); root-- > 0u;)
+            if (iPending[root].parent == None)
+                work.push_back(root);
+        while (!work.empty())
+        {
+            auto const next = work.back();
+            work.pop_back();
+            position[next] = base + static_cast<node_index>(order.size());
+            order.push_back(next);
+            auto const firstChild = work.size();
+            for (auto child = iPending[next].firstChild; child != None; child = iPending[child].nextSibling)
+                work.push_back(child);
+            std::reverse(work.begin() + firstChild, work.end());
+        }
+        iNodes.reserve(iNodes.size() + order.size());
+        for (auto p : order)
+        {
+            auto const& pending = iPending[p];
+            uint32_t childCount = 0u;
+            for (auto child = pending.firstChild; child != None; child = iPending[child].nextSibling)
+                ++childCount;
+            iNodes.push_back(node{ pending.kind, pending.parent != None ? position[pending.parent] : None, position[p] + 1u, 
+                childCount, pending.source, pending.symbol });
+        }
+        for (auto i = iNodes.size(); i-- > base;)
+        {
+            auto const parent = iNodes[i].parent;
+            if (parent != None)
+                iNodes[parent].subtreeEnd = std::max(iNodes[parent].subtreeEnd, iNodes[i].subtreeEnd);
+        }
+        iPending.clear();
+    }
+
+    void ast::clear()
+    {
+        iNodes.clear();
+        iPending.clear();
+        iConcepts.clear();
+        iIdentifiers.clear();
+        iConceptIds.clear();
+        iFragments.clear();
+    }
+
+    ast::concept_id ast::intern(const i_concept& aConcept)
+    {
+        auto existing = iConceptIds.find(&aConcept);
+        if (existing != iConceptIds.end())
+            return existing->second;
+        iConcepts.push_back(&aConcept);
+        iIdentifiers.push_back(aConcept.name().to_std_string_view() == "language.identifier");
+        return iConceptIds.emplace(&aConcept, static_cast<concept_id>(iConcepts.size() - 1u)).first->second;
+    }
+
+    ast::fragment_id ast::intern(const i_source_fragment& aFragment)
+    {
+        for (fragment_id existing = 0u; existing < iFragments.size(); ++existing)
+            if (iFragments[existing] == &aFragment)
+                return existing;
+        iFragments.push_back(&aFragment);
+        return static_cast<fragment_id>(iFragments.size() - 1u);
+    }
+}
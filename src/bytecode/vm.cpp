@@ -1,252 +1,877 @@
-/*
-  vm.cpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#include <neos/neos.hpp>
-#include <sstream>
-#include <neos/bytecode/vm/vm.hpp>
-
-namespace neos
-{
-    namespace bytecode
-    {
-        namespace vm
-        {
-            namespace cpu
-            {
-                namespace registers
-                {
-                    thread_local neos::bytecode::reg_64 r[16];
-                    thread_local neos::bytecode::reg_simd_128 x[16];
-                    thread_local neos::bytecode::reg_simd_256 y[16];
-                    thread_local neos::bytecode::reg_simd_512 z[16];
-                }
-            }
-
-            namespace
-            {
-                template <typename DataType>
-                inline DataType read_r1(opcode aOpcode)
-                {
-                    return vm::read<DataType>(r1(aOpcode));
-                }
-
-                template <typename DataType>
-                inline DataType read_r2(opcode aOpcode)
-                {
-                    return vm::read<DataType>(r2(aOpcode));
-                }
-
-                template <typename DataType>
-                inline DataType& write_r1(opcode aOpcode)
-                {
-                    return vm::write<DataType>(r1(aOpcode));
-                }
-
-                template <typename DataType>
-                inline DataType& write_r2(opcode aOpcode)
-                {
-                    return vm::write<DataType>(r2(aOpcode));
-                }
-
-                template <typename DataType>
-                inline DataType immediate(opcode aOpcode, const std::byte* aText)
-                {
-                    switch (static_cast<opcode_type>(aOpcode & opcode_type::DATA_MASK))
-                    {
-                    case opcode_type::D8:
-                    case opcode_type::D8 | opcode_type::Signed:
-                        return static_cast<DataType>(aOpcode & opcode_type::D8_MASK);
-                    default:
-                        return *reinterpret_cast<const DataType*>(aText);
-                    }
-                }
-            }
-
-            namespace instruction
-            {
-                inline void B(opcode aOpcode, const std::byte* aText)
-                {
-                    if ((static_cast<opcode_type>(aOpcode & opcode_type::Immediate)) == opcode_type::Immediate)
-                    {
-                        switch (static_cast<opcode_type>(aOpcode & opcode_type::DATA_MASK))
-                        {
-                        case opcode_type::D8:
-                            r<u64, registers::PC>() += immediate<u8>(aOpcode, aText);
-                            break;
-                        case opcode_type::D16:
-                            r<u64, registers::PC>() += immediate<u16>(aOpcode, aText);
-                            break;
-                        case opcode_type::D32:
-                            r<u64, registers::PC>() += immediate<u32>(aOpcode, aText);
-                            break;
-                        case opcode_type::D64:
-                            r<u64, registers::PC>() = immediate<u64>(aOpcode, aText);
-                            break;
-                        case opcode_type::D8 | opcode_type::Signed:
-                            r<u64, registers::PC>() += immediate<i8>(aOpcode, aText);
-                            break;
-                        case opcode_type::D16 | opcode_type::Signed:
-                            r<u64, registers::PC>() += immediate<i16>(aOpcode, aText);
-                            break;
-                        case opcode_type::D32 | opcode_type::Signed:
-                            r<u64, registers::PC>() += immediate<i32>(aOpcode, aText);
-                            break;
-                        case opcode_type::D64 | opcode_type::Signed:
-                            r<u64, registers::PC>() = immediate<i64>(aOpcode, aText);
-                            break;
-                        }
-                    }
-                }
-                template <typename DataType>
-                inline void do_ADD(u64& aRegister, DataType aData)
-                {
-                    // todo: update flags based on result of arithmetic
-                    aRegister += aData;
-                }
-                inline uint32_t ADD(opcode aOpcode, const std::byte* aText)
-                {
-                    if ((static_cast<opcode_type>(aOpcode & opcode_type::Immediate)) == opcode_type::Immediate)
-                    {
-                        switch (static_cast<opcode_type>(aOpcode & opcode_type::DATA_MASK))
-                        {
-                        case opcode_type::D8:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<u8>(aOpcode, aText));
-                            return 0u;
-                        case opcode_type::D16:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<u16>(aOpcode, aText));
-                            return 2u;
-                        case opcode_type::D32:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<u32>(aOpcode, aText));
-                            return 4u;
-                        case opcode_type::D64:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<u64>(aOpcode, aText));
-                            return 8u;
-                        case opcode_type::D8 | opcode_type::Signed:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<i8>(aOpcode, aText));
-                            return 0u;
-                        case opcode_type::D16 | opcode_type::Signed:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<i16>(aOpcode, aText));
-                            return 2u;
-                        case opcode_type::D32 | opcode_type::Signed:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<i32>(aOpcode, aText));
-                            return 4u;
-                        case opcode_type::D64 | opcode_type::Signed:
-                            do_ADD(write_r1<u64>(aOpcode), immediate<i64>(aOpcode, aText));
-                            return 8u;
-                        }
-                    }
-                    throw exceptions::invalid_instruction();
-                }
-            }
-
-            thread::thread(const text_t& aText) : 
-                iText{ aText },
-                iCount{ 0ull },
-                iTerminate{ false },
-                iResult{}
-            {
-                iNativeThread.emplace([this]()
-                {
-                    iResult = execute();
-                });
-            }
-
-            bool thread::joinable() const
-            {
-                return iNativeThread->joinable();
-            }
-
-            void thread::join()
-            {
-                try
-                {
-                    iNativeThread->join();
-                }
-                catch (std::invalid_argument)
-                {
-                }
-            }
-
-            void thread::terminate()
-            {
-                iTerminate = true;
-                join();
-            }
-
-            const std::chrono::steady_clock::time_point& thread::start_time() const
-            {
-                return iStartTime;
-            }
-
-            uint64_t thread::count() const
-            {
-                return iCountSample;
-            }
-
-            std::string thread::metrics() const
-            {
-                std::ostringstream oss;
-                auto threadId = iNativeThread->get_id();
-                oss << "[Thread " << threadId << "] Instruction count (approx): " << count() << std::endl;
-                auto instructionsPerSecond = count() / (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time()).count() / 1000000.0);
-                auto ghzFrequency = instructionsPerSecond / 1000000000.0;
-                if (ghzFrequency >= 1.0)
-                    oss << "[Thread " << threadId << "] Virtual CPU clock frequency: " << ghzFrequency << " GHz" << std::endl;
-                else
-                    oss << "[Thread " << threadId << "] Virtual CPU clock frequency: " << ghzFrequency * 1000.0 << " MHz" << std::endl;
-                return oss.str();
-            }
-
-            reg_64 thread::result() const
-            {
-                return iResult;
-            }
-
-            reg_64 thread::execute()
-            {
-                iStartTime = std::chrono::steady_clock::now();
-                if (iText.empty())
-                    throw exceptions::no_text();
-                for(;;)
-                {
-                    auto& pc = r<u64, registers::PC>();
-                    bytecode::opcode const opcode = *reinterpret_cast<const bytecode::opcode*>(&iText[pc]);
-                    pc += 4u;
-                    bytecode::opcode const opcodeInstruction = (opcode & opcode_type::OPCODE_MASK);
-                    switch (opcodeInstruction)
-                    {
-                    case bytecode::opcode::B:
-                        instruction::B(opcode, &iText[pc]);
-                        break;
-                    case bytecode::opcode::ADD:
-                        pc += instruction::ADD(opcode, &iText[pc]);
-                        break;
-                    }
-                    if ((++iCount & 0x3FFFF) == 0)
-                    {
-                        if (iTerminate)
-                            break;
-                        iCountSample = iCount;
-                    }
-                }
-                return cpu::registers::r[registers::R1 - registers::R0];
-            }
-        }
-   }
+/*
+  vm.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <neos/bytecode/vm/vm.hpp>
+
+// the integer data instructions, and the forms of each in the order of its specialised handlers: the data type 
+// (opcode bits 20 to 22) then the operand kind (register or immediate)
+#define NEOS_VM_INTEGER_INSTRUCTIONS(X) X(MOV) X(CMP) X(ADD) X(ADC) X(SUB) X(SBC) X(MUL) X(DIV) X(AND) X(OR) X(XOR) X(TEQ) X(TST)
+#define NEOS_VM_INTEGER_FORMS(X, Instruction) \
+    X(Instruction, u8, D8, false) X(Instruction, u8, D8, true) \
+    X(Instruction, u16, D16, false) X(Instruction, u16, D16, true) \
+    X(Instruction, u32, D32, false) X(Instruction, u32, D32, true) \
+    X(Instruction, u64, D64, false) X(Instruction, u64, D64, true) \
+    X(Instruction, i8, D8 | opcode_type::Signed, false) X(Instruction, i8, D8 | opcode_type::Signed, true) \
+    X(Instruction, i16, D16 | opcode_type::Signed, false) X(Instruction, i16, D16 | opcode_type::Signed, true) \
+    X(Instruction, i32, D32 | opcode_type::Signed, false) X(Instruction, i32, D32 | opcode_type::Signed, true) \
+    X(Instruction, i64, D64 | opcode_type::Signed, false) X(Instruction, i64, D64 | opcode_type::Signed, true)
+
+namespace neos
+{
+    namespace bytecode
+    {
+        namespace vm
+        {
+            namespace
+            {
+                template <typename DataType>
+                inline DataType read_r1(cpu_state& aState, opcode aOpcode)
+                {
+                    return vm::read<DataType>(aState, r1(aOpcode));
+                }
+
+                template <typename DataType>
+                inline DataType read_r2(cpu_state& aState, opcode aOpcode)
+                {
+                    return vm::read<DataType>(aState, r2(aOpcode));
+                }
+
+                template <typename DataType>
+                inline DataType& write_r1(cpu_state& aState, opcode aOpcode)
+                {
+                    return vm::write<DataType>(aState, r1(aOpcode));
+                }
+
+                template <typename DataType>
+                inline DataType& write_r2(cpu_state& aState, opcode aOpcode)
+                {
+                    return vm::write<DataType>(aState, r2(aOpcode));
+                }
+
+                template <opcode_type Data> struct data_type;
+                template <> struct data_type<opcode_type::D8> { typedef u8 type; };
+                template <> struct data_type<opcode_type::D16> { typedef u16 type; };
+                template <> struct data_type<opcode_type::D32> { typedef u32 type; };
+                template <> struct data_type<opcode_type::D64> { typedef u64 type; };
+                template <> struct data_type<opcode_type::D8 | opcode_type::Signed> { typedef i8 type; };
+                template <> struct data_type<opcode_type::D16 | opcode_type::Signed> { typedef i16 type; };
+                template <> struct data_type<opcode_type::D32 | opcode_type::Signed> { typedef i32 type; };
+                template <> struct data_type<opcode_type::D64 | opcode_type::Signed> { typedef i64 type; };
+                template <> struct data_type<opcode_type::D32 | opcode_type::Float> { typedef f32 type; };
+                template <> struct data_type<opcode_type::D64 | opcode_type::Float> { typedef f64 type; };
+                template <opcode_type Data>
+                using data_t = typename data_type<Data>::type;
+
+                // 8-bit immediates are packed into the opcode, wider ones follow it
+                template <opcode_type Data>
+                constexpr uint32_t immediate_size = sizeof(data_t<Data>) > 1u ? static_cast<uint32_t>(sizeof(data_t<Data>)) : 0u;
+
+                template <opcode_type Data>
+                inline data_t<Data> immediate(opcode aOpcode, const std::byte* aText)
+                {
+                    if constexpr (sizeof(data_t<Data>) == 1u)
+                        return static_cast<data_t<Data>>(aOpcode & opcode_type::D8_MASK);
+                    else
+                        return *reinterpret_cast<const data_t<Data>*>(aText);
+                }
+
+                template <typename Handler>
+                inline bool with_integer_data(opcode aOpcode, Handler aHandler)
+                {
+                    switch (static_cast<opcode_base_t>(aOpcode & opcode_type::DATA_MASK))
+                    {
+                    case static_cast<opcode_base_t>(opcode_type::D8):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D8>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D16):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D16>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D32):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D32>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D64):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D64>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D8 | opcode_type::Signed):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D8 | opcode_type::Signed>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D16 | opcode_type::Signed):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D16 | opcode_type::Signed>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D32 | opcode_type::Signed):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D32 | opcode_type::Signed>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D64 | opcode_type::Signed):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D64 | opcode_type::Signed>{});
+                        return true;
+                    default:
+                        return false;
+                    }
+                }
+
+                template <typename Handler>
+                inline bool with_float_data(opcode aOpcode, Handler aHandler)
+                {
+                    switch (static_cast<opcode_base_t>(aOpcode & opcode_type::DATA_MASK))
+                    {
+                    case static_cast<opcode_base_t>(opcode_type::D32 | opcode_type::Float):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D32 | opcode_type::Float>{});
+                        return true;
+                    case static_cast<opcode_base_t>(opcode_type::D64 | opcode_type::Float):
+                        aHandler(std::integral_constant<opcode_type, opcode_type::D64 | opcode_type::Float>{});
+                        return true;
+                    default:
+                        return false;
+                    }
+                }
+
+                inline bool has_immediate(opcode aOpcode)
+                {
+                    return (static_cast<opcode_type>(aOpcode & opcode_type::Immediate)) == opcode_type::Immediate;
+                }
+
+                inline bool conditional(opcode aOpcode)
+                {
+                    return (static_cast<opcode_type>(aOpcode & opcode_type::COND_MASK)) == opcode_type::Cond;
+                }
+
+                inline uint32_t condition_code(opcode aOpcode)
+                {
+                    return static_cast<opcode_base_t>(aOpcode & opcode_type::COND_OP_MASK) >> COND_SHIFT;
+                }
+
+                // size of the immediate following the opcode, if any
+                inline uint32_t operand_size(opcode aOpcode)
+                {
+                    uint32_t size = 0u;
+                    if (has_immediate(aOpcode))
+                    {
+                        auto const sizeOf = [&](auto aData) { size = immediate_size<decltype(aData)::value>; };
+                        if (!with_integer_data(aOpcode, sizeOf))
+                            with_float_data(aOpcode, sizeOf);
+                    }
+                    return size;
+                }
+
+                inline bool valid_data(opcode aOpcode)
+                {
+                    auto const ignore = [](auto) {};
+                    return with_integer_data(aOpcode, ignore) || with_float_data(aOpcode, ignore);
+                }
+
+                inline bool condition(cpu_state& aState, uint32_t aCondition)
+                {
+                    auto const flags = aState.flags();
+                    bool const cf = (flags & static_cast<u64>(flag::CF)) != 0u;
+                    bool const zf = (flags & static_cast<u64>(flag::ZF)) != 0u;
+                    bool const sf = (flags & static_cast<u64>(flag::SF)) != 0u;
+                    bool const of = (flags & static_cast<u64>(flag::OF)) != 0u;
+                    switch (static_cast<opcode_type>(aCondition << COND_SHIFT))
+                    {
+                    case opcode_type::CondEQ:
+                        return zf;
+                    case opcode_type::CondNE:
+                        return !zf;
+                    case opcode_type::CondLT:
+                        return sf != of;
+                    case opcode_type::CondLTU:
+                        return cf;
+                    case opcode_type::CondLTE:
+                        return zf || sf != of;
+                    case opcode_type::CondLTEU:
+                        return cf || zf;
+                    case opcode_type::CondGT:
+                        return !zf && sf == of;
+                    case opcode_type::CondGTU:
+                        return !cf && !zf;
+                    case opcode_type::CondGTE:
+                        return sf == of;
+                    case opcode_type::CondGTEU:
+                        return !cf;
+                    case opcode_type::CondNG:
+                        return sf;
+                    case opcode_type::CondPS:
+                        return !sf;
+                    case opcode_type::CondVS:
+                        return of;
+                    case opcode_type::CondVC:
+                        return !of;
+                    default:
+                        throw exceptions::invalid_instruction();
+                    }
+                }
+            }
+
+            u64 cpu_state::flags()
+            {
+                auto& flags = r[registers::FLAGS - registers::R0].u64;
+                auto const& pending = pendingFlags;
+                if (pending.source == flags_source::None)
+                    return flags;
+                // the operands and result are zero extended from the operation's width
+                auto const signBit = u64{ 1u } << (pending.width - 1u);
+                auto const signExtend = [&](u64 aValue) { return static_cast<i64>((aValue ^ signBit) - signBit); };
+                bool carry = false;
+                bool overflow = false;
+                switch (pending.source)
+                {
+                case flags_source::Add:
+                    carry = pending.carry ? pending.result <= pending.lhs : pending.result < pending.lhs;
+                    overflow = ((pending.lhs ^ pending.result) & (pending.rhs ^ pending.result) & signBit) != 0u;
+                    break;
+                case flags_source::Subtract:
+                    carry = pending.carry ? pending.lhs <= pending.rhs : pending.lhs < pending.rhs;
+                    overflow = ((pending.lhs ^ pending.rhs) & (pending.lhs ^ pending.result) & signBit) != 0u;
+                    break;
+                case flags_source::Multiply:
+                    carry = overflow = pending.lhs != 0u && pending.result / pending.lhs != pending.rhs;
+                    break;
+                case flags_source::MultiplySigned:
+                    {
+                        auto const lhs = signExtend(pending.lhs);
+                        auto const rhs = signExtend(pending.rhs);
+                        auto const minimum = std::numeric_limits<i64>::min();
+                        carry = overflow = lhs != 0 && ((lhs == -1 && rhs == minimum) || (rhs == -1 && lhs == minimum) || 
+                            signExtend(pending.result) / lhs != rhs);
+                    }
+                    break;
+                default:
+                    break;
+                }
+                auto parity = static_cast<u8>(pending.result);
+                parity ^= parity >> 4u;
+                parity ^= parity >> 2u;
+                parity ^= parity >> 1u;
+                u64 computed = 0u;
+                if (carry)
+                    computed |= static_cast<u64>(flag::CF);
+                if ((parity & 1u) == 0u)
+                    computed |= static_cast<u64>(flag::PF);
+                if (pending.result == 0u)
+                    computed |= static_cast<u64>(flag::ZF);
+                if ((pending.result & signBit) != 0u)
+                    computed |= static_cast<u64>(flag::SF);
+                if (overflow)
+                    computed |= static_cast<u64>(flag::OF);
+                set_flags(computed);
+                return flags;
+            }
+
+            void cpu_state::set_flags(u64 aArithmeticFlags)
+            {
+                auto& flags = r[registers::FLAGS - registers::R0].u64;
+                flags = (flags & ~ArithmeticFlags) | (aArithmeticFlags & ArithmeticFlags);
+                pendingFlags.source = flags_source::None;
+            }
+
+            namespace instruction
+            {
+                // the second operand: an immediate following the opcode (advancing aPC past it) or register r2
+                template <opcode_type Data>
+                inline data_t<Data> operand(cpu_state& aState, opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    if (has_immediate(aOpcode))
+                    {
+                        aPC += immediate_size<Data>;
+                        return immediate<Data>(aOpcode, aText);
+                    }
+                    return read<data_t<Data>>(aState, r2(aOpcode));
+                }
+
+                // integer operations work at the width of their data type: the destination and operand are 
+                // truncated to it, the destination gets the result zero extended from it and the flags are computed 
+                // at it; all but MOV record flags
+                template <opcode Instruction, opcode_type Data>
+                inline void integer(cpu_state& aState, registers aDestination, u64 aRhs)
+                {
+                    typedef cpu_state::flags_source flags_source;
+                    typedef data_t<Data> data_type;
+                    typedef std::make_unsigned_t<data_type> word;
+                    constexpr uint32_t width = sizeof(word) * 8u;
+                    auto const rhs = static_cast<u64>(static_cast<word>(aRhs));
+                    auto const lhs = static_cast<u64>(read<word>(aState, aDestination));
+                    auto const result = [&](flags_source aSource, u64 aResult, bool aCarry = false)
+                    {
+                        return aState.record_flags(aSource, width, lhs, rhs, static_cast<word>(aResult), aCarry);
+                    };
+                    if constexpr (Instruction == opcode::MOV)
+                        write<u64>(aState, aDestination) = rhs;
+                    else if constexpr (Instruction == opcode::CMP)
+                        result(flags_source::Subtract, lhs - rhs);
+                    else if constexpr (Instruction == opcode::ADD)
+                        write<u64>(aState, aDestination) = result(flags_source::Add, lhs + rhs);
+                    else if constexpr (Instruction == opcode::ADC)
+                    {
+                        bool const carry = (aState.flags() & static_cast<u64>(flag::CF)) != 0u;
+                        write<u64>(aState, aDestination) = result(flags_source::Add, lhs + rhs + carry, carry);
+                    }
+                    else if constexpr (Instruction == opcode::SUB)
+                        write<u64>(aState, aDestination) = result(flags_source::Subtract, lhs - rhs);
+                    else if constexpr (Instruction == opcode::SBC)
+                    {
+                        bool const borrow = (aState.flags() & static_cast<u64>(flag::CF)) != 0u;
+                        write<u64>(aState, aDestination) = result(flags_source::Subtract, lhs - rhs - borrow, borrow);
+                    }
+                    else if constexpr (Instruction == opcode::MUL)
+                        write<u64>(aState, aDestination) = result(std::is_signed_v<data_type> ? flags_source::MultiplySigned : flags_source::Multiply, lhs * rhs);
+                    else if constexpr (Instruction == opcode::DIV)
+                    {
+                        if (rhs == 0u)
+                            throw exceptions::division_by_zero();
+                        if constexpr (std::is_signed_v<data_type>)
+                        {
+                            // the one signed quotient that does not fit wraps
+                            auto const dividend = static_cast<i64>(static_cast<data_type>(lhs));
+                            auto const divisor = static_cast<i64>(static_cast<data_type>(rhs));
+                            auto const quotient = divisor == -1 ? 0u - lhs : static_cast<u64>(dividend / divisor);
+                            write<u64>(aState, aDestination) = result(flags_source::Logic, quotient);
+                        }
+                        else
+                            write<u64>(aState, aDestination) = result(flags_source::Logic, lhs / rhs);
+                    }
+                    else if constexpr (Instruction == opcode::AND)
+                        write<u64>(aState, aDestination) = result(flags_source::Logic, lhs & rhs);
+                    else if constexpr (Instruction == opcode::OR)
+                        write<u64>(aState, aDestination) = result(flags_source::Logic, lhs | rhs);
+                    else if constexpr (Instruction == opcode::XOR)
+                        write<u64>(aState, aDestination) = result(flags_source::Logic, lhs ^ rhs);
+                    else if constexpr (Instruction == opcode::TEQ)
+                        result(flags_source::Logic, lhs ^ rhs);
+                    else if constexpr (Instruction == opcode::TST)
+                        result(flags_source::Logic, lhs & rhs);
+                }
+
+                template <opcode_type Data>
+                inline void integer(cpu_state& aState, opcode aOpcode, u64 aRhs)
+                {
+                    switch (aOpcode & opcode_type::OPCODE_MASK)
+                    {
+#define NEOS_VM_INTEGER_CASE(Instruction) \
+                    case opcode::Instruction: \
+                        integer<opcode::Instruction, Data>(aState, r1(aOpcode), aRhs); \
+                        break;
+                    NEOS_VM_INTEGER_INSTRUCTIONS(NEOS_VM_INTEGER_CASE)
+#undef NEOS_VM_INTEGER_CASE
+                    default:
+                        throw exceptions::invalid_instruction();
+                    }
+                }
+
+                // an integer instruction as decoded: its registers are slot indices and its immediate is extended
+                template <opcode Instruction, opcode_type Data, bool Immediate>
+                inline void integer(cpu_state& aState, const decoded_text::instruction& aInstruction)
+                {
+                    auto const rhs = Immediate ? aInstruction.immediate : read<u64>(aState, static_cast<registers>(aInstruction.r2));
+                    integer<Instruction, Data>(aState, static_cast<registers>(aInstruction.r1), rhs);
+                }
+
+                // float operations work on the low f32 or f64 of the destination and leave FLAGS alone except for 
+                // CMPF, which sets them at once so that both the signed and unsigned conditions order the operands 
+                // and PF marks an unordered result
+                template <opcode_type Data>
+                inline void floating_point(cpu_state& aState, opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    typedef data_t<Data> float_type;
+                    auto const rhs = operand<Data>(aState, aOpcode, aText, aPC);
+                    auto const destination = r1(aOpcode);
+                    auto const lhs = read<float_type>(aState, destination);
+                    switch (static_cast<opcode_base_t>(aOpcode & opcode_type::OPCODE_MASK))
+                    {
+                    case static_cast<opcode_base_t>(opcode::MOV | opcode_type::Float):
+                        write<float_type>(aState, destination) = rhs;
+                        break;
+                    case static_cast<opcode_base_t>(opcode::CMPF):
+                        if (std::isunordered(lhs, rhs))
+                            aState.set_flags(static_cast<u64>(flag::PF));
+                        else if (lhs < rhs)
+                            aState.set_flags(static_cast<u64>(flag::CF) | static_cast<u64>(flag::SF));
+                        else if (lhs == rhs)
+                            aState.set_flags(static_cast<u64>(flag::ZF));
+                        else
+                            aState.set_flags(0u);
+                        break;
+                    case static_cast<opcode_base_t>(opcode::ADDF):
+                        write<float_type>(aState, destination) = lhs + rhs;
+                        break;
+                    case static_cast<opcode_base_t>(opcode::SUBF):
+                        write<float_type>(aState, destination) = lhs - rhs;
+                        break;
+                    case static_cast<opcode_base_t>(opcode::MULF):
+                        write<float_type>(aState, destination) = lhs * rhs;
+                        break;
+                    case static_cast<opcode_base_t>(opcode::DIVF):
+                        write<float_type>(aState, destination) = lhs / rhs;
+                        break;
+                    default:
+                        throw exceptions::invalid_instruction();
+                    }
+                }
+
+                inline void data(cpu_state& aState, opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    // FLAGS as an operand must be up to date before it is read or overwritten
+                    if (r1(aOpcode) == registers::FLAGS || (!has_immediate(aOpcode) && r2(aOpcode) == registers::FLAGS))
+                        aState.flags();
+                    if (!with_integer_data(aOpcode, [&](auto aData)
+                        {
+                            constexpr auto Data = decltype(aData)::value;
+                            integer<Data>(aState, aOpcode, static_cast<u64>(operand<Data>(aState, aOpcode, aText, aPC)));
+                        }) &&
+                        !with_float_data(aOpcode, [&](auto aData) { floating_point<decltype(aData)::value>(aState, aOpcode, aText, aPC); }))
+                        throw exceptions::invalid_instruction();
+                }
+
+                // 64-bit branch targets are absolute, narrower ones relative to the address following the opcode
+                template <opcode_type Data>
+                inline void branch(opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    if constexpr (sizeof(data_t<Data>) == 8u)
+                        aPC = immediate<Data>(aOpcode, aText);
+                    else
+                        aPC += immediate<Data>(aOpcode, aText);
+                }
+
+                inline void B(opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    if (has_immediate(aOpcode))
+                        with_integer_data(aOpcode, [&](auto aData) { branch<decltype(aData)::value>(aOpcode, aText, aPC); });
+                }
+
+                // aPC is the address following the opcode; memory and privileged instructions are not implemented yet
+                inline void execute(cpu_state& aState, opcode aOpcode, const std::byte* aText, u64& aPC)
+                {
+                    if (conditional(aOpcode) && !condition(aState, condition_code(aOpcode)))
+                        aPC += operand_size(aOpcode);
+                    else if ((static_cast<opcode_type>(aOpcode & opcode_type::CLASS_MASK)) == opcode_type::Data)
+                        data(aState, aOpcode, aText, aPC);
+                    else if ((aOpcode & opcode_type::OPCODE_MASK) == opcode::B)
+                        B(aOpcode, aText, aPC);
+                }
+            }
+
+            namespace
+            {
+                // the decoded integer instructions' handlers, 16 forms per instruction in NEOS_VM_INTEGER_FORMS order
+                typedef void (*integer_handler)(cpu_state&, const decoded_text::instruction&);
+#define NEOS_VM_INTEGER_FUNCTION(Instruction, Type, Data, Immediate) &instruction::integer<opcode::Instruction, opcode_type::Data, Immediate>,
+#define NEOS_VM_INTEGER_FUNCTIONS(Instruction) NEOS_VM_INTEGER_FORMS(NEOS_VM_INTEGER_FUNCTION, Instruction)
+                const integer_handler integer_handlers[] = { NEOS_VM_INTEGER_INSTRUCTIONS(NEOS_VM_INTEGER_FUNCTIONS) };
+#undef NEOS_VM_INTEGER_FUNCTIONS
+#undef NEOS_VM_INTEGER_FUNCTION
+
+                constexpr uint32_t integer_form_count = 16u;
+                constexpr opcode_base_t DATA_SHIFT = 20u;
+
+                // the index of the handler for an unconditional integer instruction, if it has one
+                inline std::optional<uint16_t> integer_form(opcode aOpcode)
+                {
+#define NEOS_VM_INTEGER_OPCODE(Instruction) opcode::Instruction,
+                    static constexpr opcode instructions[] = { NEOS_VM_INTEGER_INSTRUCTIONS(NEOS_VM_INTEGER_OPCODE) };
+#undef NEOS_VM_INTEGER_OPCODE
+                    auto const instruction = std::find(std::begin(instructions), std::end(instructions), aOpcode & opcode_type::OPCODE_MASK);
+                    if (instruction == std::end(instructions) || conditional(aOpcode) || !with_integer_data(aOpcode, [](auto) {}))
+                        return {};
+                    auto const data = static_cast<opcode_base_t>(aOpcode & (opcode_type::D64 | opcode_type::Signed)) >> DATA_SHIFT;
+                    return static_cast<uint16_t>((instruction - std::begin(instructions)) * integer_form_count + data * 2u + (has_immediate(aOpcode) ? 1u : 0u));
+                }
+            }
+
+            decoded_text::decoded_text(const text_t& aText) :
+                iText{ aText }, iIndex(aText.size(), None), iBound{ 0u }
+            {
+                iInstructions.push_back(instruction{ nullptr, 0u, End, static_cast<uint32_t>(aText.size()), operation::End, 0u, 0u, 0u });
+                decode(0u);
+            }
+
+            const decoded_text::instructions_t& decoded_text::instructions() const
+            {
+                return iInstructions;
+            }
+
+            const decoded_text::instruction& decoded_text::operator[](index_type aIndex) const
+            {
+                return iInstructions[aIndex];
+            }
+
+            decoded_text::index_type decoded_text::index_of(u64 aPC)
+            {
+                if (!decodable(aPC))
+                    return End;
+                if (iIndex[aPC] == None)
+                    decode(aPC);
+                return iIndex[aPC];
+            }
+
+            void decoded_text::bind(const void* const* aHandlers, const void* const* aIntegerHandlers)
+            {
+                for (; iBound < iInstructions.size(); ++iBound)
+                {
+                    auto& instruction = iInstructions[iBound];
+                    instruction.handler = instruction.op == operation::Integer ? aIntegerHandlers[instruction.form] : aHandlers[static_cast<uint32_t>(instruction.op)];
+                }
+            }
+
+            void decoded_text::decode(u64 aPC)
+            {
+                // decode straight line runs from each start; a branch ends a run and starts another at its target, a 
+                // conditional branch starts another without ending its own
+                std::vector<u64> starts{ aPC };
+                std::vector<std::pair<index_type, u64>> branches;
+                while (!starts.empty())
+                {
+                    auto pc = starts.back();
+                    starts.pop_back();
+                    index_type previous = None;
+                    for (;;)
+                    {
+                        index_type const existing = decodable(pc) ? iIndex[pc] : End;
+                        if (existing != None)
+                        {
+                            if (previous != None)
+                                iInstructions[previous].next = existing;
+                            break;
+                        }
+                        u64 nextPC;
+                        std::optional<u64> target;
+                        auto const index = static_cast<index_type>(iInstructions.size());
+                        iInstructions.push_back(decode(pc, nextPC, target));
+                        iIndex[pc] = index;
+                        if (previous != None)
+                            iInstructions[previous].next = index;
+                        if (target)
+                        {
+                            branches.emplace_back(index, *target);
+                            starts.push_back(*target);
+                        }
+                        if (iInstructions[index].op == operation::Branch || iInstructions[index].op == operation::End)
+                            break;
+                        previous = index;
+                        pc = nextPC;
+                    }
+                }
+                for (auto const& branch : branches)
+                {
+                    auto& entry = iInstructions[branch.first];
+                    auto const target = decodable(branch.second) ? iIndex[branch.second] : End;
+                    if (entry.op == operation::BranchIf)
+                        entry.immediate = target;
+                    else
+                        entry.next = target;
+                }
+            }
+
+            bool decoded_text::decodable(u64 aPC) const
+            {
+                return aPC < iText.size() && iText.size() - aPC >= 4u;
+            }
+
+            decoded_text::instruction decoded_text::decode(u64 aPC, u64& aNextPC, std::optional<u64>& aTarget) const
+            {
+                auto const opcode = *reinterpret_cast<const bytecode::opcode*>(&iText[aPC]);
+                instruction result{ nullptr, 0u, End, static_cast<uint32_t>(aPC), operation::Nop, 
+                    static_cast<uint8_t>(r1(opcode) - registers::R0), static_cast<uint8_t>(r2(opcode) - registers::R0), 0u };
+                aNextPC = aPC + 4u;
+                if (iText.size() - aNextPC < operand_size(opcode))
+                {
+                    result.op = operation::End;
+                    return result;
+                }
+                if ((opcode & opcode_type::OPCODE_MASK) == bytecode::opcode::B)
+                {
+                    if (has_immediate(opcode))
+                        with_integer_data(opcode, [&](auto aData)
+                        {
+                            u64 target = aNextPC;
+                            vm::instruction::branch<decltype(aData)::value>(opcode, &iText[aNextPC], target);
+                            aTarget = target;
+                            if (!conditional(opcode))
+                                result.op = operation::Branch;
+                            else if (condition_code(opcode) <= (static_cast<opcode_base_t>(opcode_type::CondVC) >> COND_SHIFT))
+                            {
+                                result.op = operation::BranchIf;
+                                result.r1 = static_cast<uint8_t>(condition_code(opcode));
+                            }
+                            else
+                                result.op = operation::Invalid;
+                        });
+                    aNextPC += operand_size(opcode);
+                }
+                else if ((static_cast<opcode_type>(opcode & opcode_type::CLASS_MASK)) == opcode_type::Data)
+                {
+                    // PC and FLAGS operands need the generic path: it keeps PC current and FLAGS materialised
+                    aNextPC += operand_size(opcode);
+                    auto const special = [](registers aRegister) { return aRegister == registers::PC || aRegister == registers::FLAGS; };
+                    auto const form = integer_form(opcode);
+                    if (!valid_data(opcode))
+                        result.op = operation::Invalid;
+                    else if (form && !special(r1(opcode)) && (has_immediate(opcode) || !special(r2(opcode))))
+                    {
+                        result.op = operation::Integer;
+                        result.form = *form;
+                        if (has_immediate(opcode))
+                            with_integer_data(opcode, [&](auto aData)
+                            {
+                                constexpr auto Data = decltype(aData)::value;
+                                result.immediate = static_cast<u64>(immediate<Data>(opcode, &iText[aPC + 4u]));
+                            });
+                    }
+                    else
+                        result.op = operation::Generic;
+                }
+                if (result.op == operation::Nop && conditional(opcode))
+                    result.op = operation::Generic;
+                return result;
+            }
+
+            thread::thread(const text_t& aText, dispatch aDispatch) : 
+                iText{ aText },
+                iDispatch{ aDispatch },
+                iCount{ 0ull },
+                iTerminate{ false },
+                iResult{}
+            {
+                if (iDispatch != dispatch::Switch)
+                    iDecoded.emplace(iText);
+                // guest errors (an invalid instruction, a division by zero) must not escape the native thread; they 
+                // are rethrown by join() and result()
+                iNativeThread.emplace([this]()
+                {
+                    try
+                    {
+                        iResult = execute();
+                    }
+                    catch (...)
+                    {
+                        iError = std::current_exception();
+                    }
+                });
+            }
+
+            bool thread::joinable() const
+            {
+                return iNativeThread->joinable();
+            }
+
+            void thread::join()
+            {
+                try
+                {
+                    iNativeThread->join();
+                }
+                catch (const std::invalid_argument&)
+                {
+                }
+                if (iError)
+                    std::rethrow_exception(iError);
+            }
+
+            void thread::terminate()
+            {
+                iTerminate = true;
+                join();
+            }
+
+            const std::chrono::steady_clock::time_point& thread::start_time() const
+            {
+                return iStartTime;
+            }
+
+            uint64_t thread::count() const
+            {
+                return iCountSample;
+            }
+
+            std::string thread::metrics() const
+            {
+                std::ostringstream oss;
+                auto threadId = iNativeThread->get_id();
+                oss << "[Thread " << threadId << "] Instruction count (approx): " << count() << std::endl;
+                auto instructionsPerSecond = count() / (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time()).count() / 1000000.0);
+                auto ghzFrequency = instructionsPerSecond / 1000000000.0;
+                if (ghzFrequency >= 1.0)
+                    oss << "[Thread " << threadId << "] Virtual CPU clock frequency: " << ghzFrequency << " GHz" << std::endl;
+                else
+                    oss << "[Thread " << threadId << "] Virtual CPU clock frequency: " << ghzFrequency * 1000.0 << " MHz" << std::endl;
+                return oss.str();
+            }
+
+            reg_64 thread::result() const
+            {
+                if (iError)
+                    std::rethrow_exception(iError);
+                return iResult;
+            }
+
+            reg_64 thread::execute()
+            {
+                iStartTime = std::chrono::steady_clock::now();
+                if (iText.empty())
+                    throw exceptions::no_text();
+                reg_64 result;
+#ifdef NEOS_VM_THREADED_DISPATCH
+                if (iDispatch == dispatch::Threaded)
+                    result = execute_threaded();
+                else
+#endif
+                if (iDispatch == dispatch::Switch)
+                    result = execute_switch();
+                else
+                    result = execute_decoded();
+                iState.flags();
+                return result;
+            }
+
+            reg_64 thread::execute_switch()
+            {
+                for(;;)
+                {
+                    auto& pc = r<u64, registers::PC>(iState);
+                    bytecode::opcode const opcode = *reinterpret_cast<const bytecode::opcode*>(&iText[pc]);
+                    pc += 4u;
+                    instruction::execute(iState, opcode, &iText[pc], pc);
+                    if ((++iCount & 0x3FFFF) == 0)
+                    {
+                        if (iTerminate)
+                            break;
+                        iCountSample = iCount;
+                    }
+                }
+                return iState.r[registers::R1 - registers::R0];
+            }
+
+            reg_64 thread::execute_decoded()
+            {
+                auto& decoded = *iDecoded;
+                auto& pc = r<u64, registers::PC>(iState);
+                auto index = decoded.index_of(pc);
+                for (;;)
+                {
+                    auto const& instruction = decoded[index];
+                    switch (instruction.op)
+                    {
+                    case decoded_text::operation::Nop:
+                    case decoded_text::operation::Branch:
+                        index = instruction.next;
+                        break;
+                    case decoded_text::operation::BranchIf:
+                        index = condition(iState, instruction.r1) ? static_cast<decoded_text::index_type>(instruction.immediate) : instruction.next;
+                        break;
+                    case decoded_text::operation::Integer:
+                        integer_handlers[instruction.form](iState, instruction);
+                        index = instruction.next;
+                        break;
+                    case decoded_text::operation::Generic:
+                        index = execute_generic(instruction);
+                        break;
+                    case decoded_text::operation::Invalid:
+                        throw exceptions::invalid_instruction();
+                    case decoded_text::operation::End:
+                        pc = instruction.pc;
+                        return iState.r[registers::R1 - registers::R0];
+                    }
+                    if ((++iCount & 0x3FFFF) == 0)
+                    {
+                        if (iTerminate)
+                            break;
+                        iCountSample = iCount;
+                    }
+                }
+                pc = decoded[index].pc;
+                return iState.r[registers::R1 - registers::R0];
+            }
+
+#ifdef NEOS_VM_THREADED_DISPATCH
+#define NEOS_VM_DISPATCH(next) \
+    { \
+        auto const nextIndex = next; \
+        if ((++iCount & 0x3FFFF) == 0) \
+        { \
+            if (iTerminate) \
+            { \
+                pc = decoded[nextIndex].pc; \
+                goto terminate; \
+            } \
+            iCountSample = iCount; \
+        } \
+        instruction = &decoded[nextIndex]; \
+        goto *instruction->handler; \
+    }
+
+            reg_64 thread::execute_threaded()
+            {
+                // indexed by decoded_text::operation (integer instructions are bound to their form's label) and by 
+                // form, one label per integer instruction, data type and operand kind
+                static const void* const handlers[] = { &&next, &&next, &&branch_if, &&invalid, &&generic, &&invalid, &&end };
+#define NEOS_VM_INTEGER_LABEL(Instruction, Type, Data, Immediate) &&integer_##Instruction##_##Type##_##Immediate,
+#define NEOS_VM_INTEGER_LABELS(Instruction) NEOS_VM_INTEGER_FORMS(NEOS_VM_INTEGER_LABEL, Instruction)
+                static const void* const integerHandlers[] = { NEOS_VM_INTEGER_INSTRUCTIONS(NEOS_VM_INTEGER_LABELS) };
+#undef NEOS_VM_INTEGER_LABELS
+#undef NEOS_VM_INTEGER_LABEL
+                auto& decoded = *iDecoded;
+                auto& pc = r<u64, registers::PC>(iState);
+                auto instruction = &decoded[decoded.index_of(pc)];
+                decoded.bind(handlers, integerHandlers);
+                goto *instruction->handler;
+            next:
+                NEOS_VM_DISPATCH(instruction->next)
+            branch_if:
+                NEOS_VM_DISPATCH(condition(iState, instruction->r1) ? static_cast<decoded_text::index_type>(instruction->immediate) : instruction->next)
+#define NEOS_VM_INTEGER_HANDLER(Instruction, Type, Data, Immediate) \
+            integer_##Instruction##_##Type##_##Immediate: \
+                vm::instruction::integer<opcode::Instruction, opcode_type::Data, Immediate>(iState, *instruction); \
+                NEOS_VM_DISPATCH(instruction->next)
+#define NEOS_VM_INTEGER_HANDLERS(Instruction) NEOS_VM_INTEGER_FORMS(NEOS_VM_INTEGER_HANDLER, Instruction)
+                NEOS_VM_INTEGER_INSTRUCTIONS(NEOS_VM_INTEGER_HANDLERS)
+#undef NEOS_VM_INTEGER_HANDLERS
+#undef NEOS_VM_INTEGER_HANDLER
+            generic:
+                {
+                    auto const genericNext = execute_generic(*instruction);
+                    decoded.bind(handlers, integerHandlers);
+                    NEOS_VM_DISPATCH(genericNext)
+                }
+            invalid:
+                throw exceptions::invalid_instruction();
+            end:
+                pc = instruction->pc;
+            terminate:
+                return iState.r[registers::R1 - registers::R0];
+            }
+
+#undef NEOS_VM_DISPATCH
+#endif
+
+            decoded_text::index_type thread::execute_generic(const decoded_text::instruction& aInstruction)
+            {
+                // instructions the decoder has no specialised operation for run as the switch loop runs them
+                auto& pc = r<u64, registers::PC>(iState);
+                bytecode::opcode const opcode = *reinterpret_cast<const bytecode::opcode*>(&iText[aInstruction.pc]);
+                pc = aInstruction.pc + 4u;
+                instruction::execute(iState, opcode, &iText[pc], pc);
+                return iDecoded->index_of(pc);
+            }
+        }
+   }
 }
\ No newline at end of file
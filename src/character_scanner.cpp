@@ -0,0 +1,129 @@
+/*
+  character_scanner.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NEOS_CHARACTER_SCANNER_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEOS_CHARACTER_SCANNER_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <neos/language/character_scanner.hpp>
+
+namespace neos::language
+{
+    namespace
+    {
+        inline uint32_t first_clear_bit(uint32_t aMask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, ~aMask);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctz(~aMask));
+#endif
+        }
+    }
+
+    character_scanner::character_scanner(const character_set& aCharacters) :
+        iCharacters{ aCharacters }, iRanges{}, iRangeCount{ 0u }
+    {
+        for (uint32_t ch = 0u; ch < 256u; ++ch)
+        {
+            if (!iCharacters.test(static_cast<char>(ch)))
+                continue;
+            if (iRangeCount > 0u && iRanges[iRangeCount - 1u].last + 1u == ch)
+                iRanges[iRangeCount - 1u].last = static_cast<unsigned char>(ch);
+            else if (iRangeCount < MaxRanges)
+                iRanges[iRangeCount++] = range{ static_cast<unsigned char>(ch), static_cast<unsigned char>(ch) };
+            else
+            {
+                // too fragmented to be worth range compares; fall back to the bitmap
+                iRangeCount = 0u;
+                break;
+            }
+        }
+    }
+
+    const character_set& character_scanner::characters() const
+    {
+        return iCharacters;
+    }
+
+    bool character_scanner::vectorized() const
+    {
+#if defined(NEOS_CHARACTER_SCANNER_SSE2) || defined(NEOS_CHARACTER_SCANNER_AVX2)
+        return iRangeCount != 0u;
+#else
+        return false;
+#endif
+    }
+
+    std::size_t character_scanner::scan(const char* aFirst, const char* aLast) const
+    {
+        auto next = aFirst;
+        if (iRangeCount != 0u)
+        {
+            // a byte x is in [first, last] iff (x - first) <= (last - first) as an unsigned byte: min_epu8(d, span) == d
+#ifdef NEOS_CHARACTER_SCANNER_AVX2
+            while (aLast - next >= 32)
+            {
+                auto const block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next));
+                auto in = _mm256_setzero_si256();
+                for (std::size_t r = 0u; r < iRangeCount; ++r)
+                {
+                    auto const delta = _mm256_sub_epi8(block, _mm256_set1_epi8(static_cast<char>(iRanges[r].first)));
+                    auto const span = _mm256_set1_epi8(static_cast<char>(iRanges[r].last - iRanges[r].first));
+                    in = _mm256_or_si256(in, _mm256_cmpeq_epi8(_mm256_min_epu8(delta, span), delta));
+                }
+                auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(in));
+                if (mask != 0xFFFFFFFFu)
+                    return (next - aFirst) + first_clear_bit(mask);
+                next += 32;
+            }
+#endif
+#ifdef NEOS_CHARACTER_SCANNER_SSE2
+            while (aLast - next >= 16)
+            {
+                auto const block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next));
+                auto in = _mm_setzero_si128();
+                for (std::size_t r = 0u; r < iRangeCount; ++r)
+                {
+                    auto const delta = _mm_sub_epi8(block, _mm_set1_epi8(static_cast<char>(iRanges[r].first)));
+                    auto const span = _mm_set1_epi8(static_cast<char>(iRanges[r].last - iRanges[r].first));
+                    in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_min_epu8(delta, span), delta));
+                }
+                auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(in)) | 0xFFFF0000u;
+                if (mask != 0xFFFFFFFFu)
+                    return (next - aFirst) + first_clear_bit(mask);
+                next += 16;
+            }
+#endif
+        }
+        while (next != aLast && iCharacters.test(*next))
+            ++next;
+        return next - aFirst;
+    }
+}
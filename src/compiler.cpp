@@ -1,813 +1,1312 @@
-/*
-  compiler.cpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#include <neolib/neolib.hpp>
-#include <iostream>
-#include <neolib/core/scoped.hpp>
-#include <neolib/core/recursion.hpp>
-#include <neolib/core/string_utf.hpp>
-#include <neos/bytecode/opcodes.hpp>
-#include <neos/bytecode/text.hpp>
-#include <neos/language/compiler.hpp>
-
-namespace neos::language
-{
-    compiler::scoped_concept_folder::scoped_concept_folder(compiler& aCompiler, compiler_pass aPass) :
-        scoped_concept_folder{ aCompiler, aPass, aCompiler.parse_stack() }
-    {
-    }
-
-    compiler::scoped_concept_folder::scoped_concept_folder(compiler& aCompiler, compiler_pass aPass, concept_stack_t& aStack) :
-        iCompiler{ aCompiler }, iPass{ aPass }, iStack{ aStack }, iScopeStart{ aStack.size() }
-    {
-    }
-
-    compiler::scoped_concept_folder::~scoped_concept_folder()
-    {
-        fold();
-    }
-
-    void compiler::scoped_concept_folder::fold()
-    {
-        if (iPass == compiler_pass::Emit)
-        {
-            std::for_each(stack().begin() + iScopeStart, stack().end(), 
-                [this](const concept_stack_entry& aEntry)
-                {
-                    if (aEntry.concept_ != nullptr)
-                    {
-                        iCompiler.fold_stack().push_back(aEntry);
-                        if (iCompiler.trace() >= 2)
-                            std::cout << "prefold: " << "<" << aEntry.level << ": " << location(*aEntry.unit, *aEntry.fragment, aEntry.sourceStart, false) << "> "
-                                << aEntry.concept_->name() << " (" << std::string(aEntry.sourceStart, aEntry.sourceEnd) << ")" << std::endl;
-                    }
-                });
-            iCompiler.fold();
-        }
-        stack().erase(stack().begin() + iScopeStart, stack().end());
-    }
-
-    void compiler::scoped_concept_folder::move_to(concept_stack_t& aOtherStack)
-    {
-        if (iPass == compiler_pass::Emit)
-            aOtherStack.insert(aOtherStack.end(), stack().begin() + iScopeStart, stack().end());
-        stack().erase(stack().begin() + iScopeStart, stack().end());
-    }
-
-    compiler::concept_stack_t& compiler::scoped_concept_folder::stack()
-    {
-        return iStack;
-    }
-
-    compiler::compiler(i_context& aContext) :
-        iContext{ aContext }, iTrace { 0u }, iStartTime{ std::chrono::steady_clock::now() }, iEndTime{ std::chrono::steady_clock::now() }
-    {
-    }
-
-    uint32_t compiler::trace() const
-    {
-        return iTrace;
-    }
-
-    const std::optional<std::string>& compiler::trace_filter() const
-    {
-        return iTraceFilter;
-    }
-
-    void compiler::set_trace(uint32_t aTrace, const std::optional<std::string>& aFilter)
-    {
-        iTrace = aTrace;
-        iTraceFilter = aFilter;
-    }
-
-    const std::chrono::steady_clock::time_point& compiler::start_time() const
-    {
-        return iStartTime;
-    }
-
-    const std::chrono::steady_clock::time_point& compiler::end_time() const
-    {
-        return iEndTime;
-    }
-
-    void compiler::compile(program& aProgram)
-    {
-        for (auto& unit : aProgram.translationUnits)
-            for (auto fragment = unit.fragments.begin(); fragment != unit.fragments.end();)
-                if (fragment->imported())
-                    fragment = unit.fragments.erase(fragment);
-                else
-                    (fragment++)->set_status(compilation_status::Pending);
-
-        iStartTime = std::chrono::steady_clock::now();
-
-        try
-        {
-            for (auto& unit : aProgram.translationUnits)
-                compile(aProgram, unit);
-        }
-        catch(...)
-        {
-            iEndTime = std::chrono::steady_clock::now();
-            throw;
-        }
-
-        iEndTime = std::chrono::steady_clock::now();
-    }
-
-    void compiler::compile(program& aProgram, translation_unit& aUnit)
-    {
-        for (auto& fragment : aUnit.fragments)
-            compile(aProgram, aUnit, fragment);
-    }
-
-    void compiler::compile(program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment)
-    {
-        if (aFragment.status() != compilation_status::Pending)
-            return;
-
-        aFragment.set_status(compilation_status::Compiling);
-            
-        iCompilationStateStack.push_back(std::unique_ptr<compilation_state>(new compilation_state{ &aProgram, &aUnit }));
-
-        auto source = aFragment.cbegin();
-        while (source != aFragment.cend())
-        {
-            state().iDeepestProbe = std::nullopt;
-            auto result = parse(compiler_pass::Emit, aProgram, aUnit, aFragment, aUnit.schema->root(), source);
-            if (result.action == parse_result::NoMatch)
-            {
-                if (trace() >= 3 && state().iDeepestProbe)
-                    display_probe_trace(aUnit, aFragment);
-                throw_error(aUnit, aFragment, state().iDeepestProbe ? state().iDeepestProbe->source : source, "syntax error");
-            }
-            source = result.sourceParsed;
-        }
-
-        aFragment.set_status(compilation_status::Compiled);
-
-        iCompilationStateStack.pop_back();
-    }
-
-    void compiler::compile(const i_source_fragment& aFragment)
-    {
-        auto& program = *state().program;
-        auto& unit = *state().unit;
-        auto& fragment = *unit.fragments.emplace(unit.fragments.end(), aFragment);
-        compile(program, unit, fragment);
-    }
-
-    const compiler::compilation_state& compiler::state() const
-    {
-        return *iCompilationStateStack.back();
-    }
-
-    compiler::compilation_state& compiler::state()
-    {
-        return *iCompilationStateStack.back();
-    }
-
-    compiler::parse_result compiler::parse(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, source_iterator aSource)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        neolib::scoped_counter sc{ state().iLevel };
-        scoped_stack_trace sst{ *this, aAtom, aSource, "parse" };
-        if (aPass == compiler_pass::Emit)
-        {
-            auto probeResult = parse(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aSource);
-            if (probeResult.action == parse_result::NoMatch)
-                return probeResult;
-        }
-        if (trace() >= 4)
-            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse(" << aAtom.symbol() << ")" << std::endl;
-        scoped_concept_folder scs{ *this, aPass };
-        bool const expectingToken = !aAtom.expects().empty();
-        if (aSource != aFragment.cend())
-        {
-            if (expectingToken)
-            {
-                for (auto const& expect : aAtom.expects())
-                {
-                    auto recursiveLevel = aAtom.recursive_token(*expect);
-                    if (aAtom.expects().size() == 1 && recursiveLevel != 0u)
-                    {
-                        if (aPass == compiler_pass::Emit && postfix_operation_stack().size() >= 2)
-                        {
-                            auto const& current = *std::prev(postfix_operation_stack().end());
-                            auto& previous = *std::prev(std::prev(postfix_operation_stack().end()));
-                            if (current.level == previous.level + recursiveLevel && previous.concept_ != nullptr &&
-                                aAtom.token().is_conceptually_related_to(*current.concept_) &&
-                                aAtom.token().is_conceptually_related_to(*previous.concept_))
-                            {
-                                parse_stack().push_back(previous);
-                                scs.fold();
-                                previous.concept_ = nullptr;
-                            }
-                        }
-                    }
-                    auto result = parse_tokens(aPass, aProgram, aUnit, aFragment, aAtom, expected{ &*expect, &aAtom }, aSource);
-                    if (is_finished(result) || result.action == parse_result::Consumed)
-                        return result;
-                    if (state().iDeepestProbe == std::nullopt || state().iDeepestProbe->source < result.sourceParsed)
-                        state().iDeepestProbe = deepest_probe{ result.sourceParsed, { state().iStackTrace } };
-                    else if (state().iDeepestProbe->source == result.sourceParsed)
-                        state().iDeepestProbe->stacks.push_back(state().iStackTrace);
-                }
-                return parse_result{ aSource, parse_result::NoMatch };
-            }
-            else
-                return parse_tokens(aPass, aProgram, aUnit, aFragment, aAtom, expected{}, aSource);
-        }
-        else
-            return expectingToken ? parse_result{ aSource, parse_result::NoMatch } : parse_result{ aSource };
-        //auto loop = emit(aProgram.text, bytecode::opcode::ADD, bytecode::registers::R1, bytecode::u64{ 10 });
-        //emit(aProgram.text, bytecode::opcode::ADD, bytecode::registers::R1, bytecode::i8{ -1 });
-        //emit(aProgram.text, bytecode::opcode::B, loop);
-    }
-
-    compiler::parse_result compiler::parse_tokens(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const expected& aExpected, source_iterator aSource)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        if (aPass == compiler_pass::Emit)
-        {
-            auto probeResult = parse_tokens(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aExpected, aSource);
-            if (probeResult.action == parse_result::NoMatch)
-                return probeResult;
-        }
-        if (trace() >= 4)
-            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_tokens(" << aAtom.symbol() << ")" << std::endl;
-        scoped_concept_folder scs{ *this, aPass };
-        auto currentSource = aSource;
-        bool defaultOk = aAtom.expect_none();
-        auto expectedAtom = aExpected.what;
-        auto expectedConsumed = aExpected.consumed;
-        bool const consumeSelf = (expectedAtom == nullptr || *aExpected.context == aAtom);
-        bool handledExpect = false;
-        if (expectedAtom && expectedAtom->is_schema_atom() && expectedAtom->as_schema_atom().is_schema_node_atom() &&
-            expectedAtom->as_schema_atom().as_schema_node_atom().as())
-        {
-            auto result = parse(aPass, aProgram, aUnit, aFragment, expectedAtom->as_schema_atom().as_schema_node_atom(), currentSource);
-            if (is_finished(result))
-            {
-                currentSource = result.sourceParsed;
-                expectedAtom = result.atom;
-                expectedConsumed = true;
-            }
-        }
-        auto iterToken = expectedAtom ?
-            std::find_if(aAtom.tokens().begin(), aAtom.tokens().end(), [expectedAtom](auto&& tokensEntry)
-            { 
-                auto const& token = *tokensEntry.first();
-                return *expectedAtom == token;
-            }) : 
-            aAtom.tokens().begin();
-        if (expectedAtom && iterToken == aAtom.tokens().end())
-        {
-            iterToken = expectedAtom ?
-                std::find_if(aAtom.tokens().begin(), aAtom.tokens().end(), [expectedAtom](auto&& tokensEntry)
-                { 
-                    auto const& token = *tokensEntry.first();
-                    return expectedAtom->is_conceptually_related_to(token);
-                }) : 
-                aAtom.tokens().begin();
-        }
-        if (expectedAtom && iterToken == aAtom.tokens().end())
-        {
-            if (aAtom.has_parent())
-                return parse_tokens(aPass, aProgram, aUnit, aFragment, aAtom.parent().as_schema_atom().as_schema_node_atom(), aExpected, aSource);
-            return parse_result{ aSource, parse_result::NoMatch };
-        }
-        bool skipConsume = (expectedAtom && expectedConsumed);
-        for (; currentSource != aFragment.cend() && iterToken != aAtom.tokens().end();)
-        {
-            auto const& token = *iterToken->first();
-            auto const& tokenValue = *iterToken->second();
-            if (aAtom.is_token_node() && aAtom.token() == token)
-                defaultOk = true;
-            parse_result result{ currentSource };
-            if (!skipConsume)
-                result = parse_token(aPass, aProgram, aUnit, aFragment, aAtom, token, result);
-            skipConsume = false;
-            if (finished(result))
-            {
-                if (aAtom.as() && aAtom.is_conceptually_related_to(tokenValue))
-                    result.atom = &token;
-                if (token.is_schema_atom() && token.as_schema_atom().is_schema_node_atom() && token.as_schema_atom().as_schema_node_atom().is_token_node())
-                    return consume_token(aPass, aProgram, aUnit, aFragment, aAtom, result);
-            }
-            bool const ateSome = (result.action == parse_result::Consumed);
-            if (ateSome)
-            {
-                defaultOk = true;
-                auto const& matchedTokenValue = tokenValue;
-                if (!matchedTokenValue.is_schema_atom() || matchedTokenValue.as_schema_atom().is_schema_node_atom())
-                {
-                    if (aAtom.is_parent_of(matchedTokenValue) || aAtom.is_sibling_of(matchedTokenValue))
-                        result = parse_token(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
-                    if (aAtom.as() && aAtom.is_conceptually_related_to(matchedTokenValue))
-                        result.atom = &matchedTokenValue;
-                    if (is_finished(result))
-                    {
-                        if (consumeSelf)
-                            result = consume_token(aPass, aProgram, aUnit, aFragment, aAtom, result);
-                        if (aAtom.is_parent_of(matchedTokenValue))
-                            return result;
-                        if (consumeSelf && result.action == parse_result::Done)
-                            finished(result);
-                    }
-                    if (result.action == parse_result::Consumed)
-                    {
-                        if (matchedTokenValue.is_concept_atom())
-                        {
-                            result = parse_token_match(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
-                            if (is_finished(result))
-                                return consumeSelf ? consume_token(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
-                        }
-                        else
-                        {
-                            result = parse_token_match(aPass, aProgram, aUnit, aFragment, matchedTokenValue.as_schema_atom().as_schema_node_atom(), token, result, false);
-                            if (is_finished(result))
-                            {
-                                result = consume_token(aPass, aProgram, aUnit, aFragment, matchedTokenValue, result);
-                                return consumeSelf ? consume_token(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
-                            }
-                            if (result.action == parse_result::Consumed)
-                            {
-                                result = parse_token_match(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result, aAtom.is_parent_of(matchedTokenValue));
-                                if (is_finished(result))
-                                    return consumeSelf ? consume_token(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
-                            }
-                        }
-                        if (result.action == parse_result::Consumed)
-                        {
-                            currentSource = result.sourceParsed;
-                            iterToken = aAtom.tokens().begin();
-                        }
-                        else if (is_finished(result))
-                            return result;
-                        else
-                            ++iterToken;
-                    }
-                    else if (result.action == parse_result::Consumed)
-                        ++iterToken;
-                    else
-                        return result;
-                }
-                else if (matchedTokenValue.is_schema_atom() && matchedTokenValue.as_schema_atom().is_schema_terminal_atom())
-                {
-                    result = parse_token(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
-                    switch(result.action)
-                    {
-                    case parse_result::Drain:
-                    case parse_result::Done:
-                    case parse_result::ForNext:
-                        return result;
-                    case parse_result::Ignored:
-                    case parse_result::Continue:
-                        currentSource = result.sourceParsed;
-                        iterToken = aAtom.tokens().begin();
-                        break;
-                    case parse_result::NoMatch:
-                        if (token.is_schema_atom() && token.as_schema_atom().is_schema_terminal_atom() && token.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::String)
-                            result.sourceParsed = std::prev(result.sourceParsed, token.symbol().size());
-                        return result;
-                    case parse_result::Error:
-                        return parse_result{ result.sourceParsed, parse_result::NoMatch };
-                    default:
-                        /* do nothing */
-                        break;
-                    }
-                }
-                else
-                    return result;
-            }
-            else
-            {
-                if (!handledExpect && aExpected.what)
-                    return parse_result{ aSource, parse_result::NoMatch };
-                ++iterToken;
-            }
-            handledExpect = true;
-            if (iterToken == aAtom.tokens().end())
-            {
-                if (token.is_schema_atom() && token.as_schema_atom().is_schema_terminal_atom() &&
-                    token.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::Default)
-                {
-                    auto result = parse_token(aPass, aProgram, aUnit, aFragment, aAtom, tokenValue, parse_result{ currentSource });
-                    switch (result.action)
-                    {
-                    case parse_result::Drain:
-                    case parse_result::Done:
-                    case parse_result::ForNext:
-                        return defaultOk ? result : result.with(parse_result::NoMatch);
-                    case parse_result::Consumed:
-                        currentSource = result.sourceParsed;
-                        break;
-                    case parse_result::Ignored:
-                        if (!ateSome && currentSource == result.sourceParsed)
-                            ++currentSource;
-                        iterToken = aAtom.tokens().begin();
-                        break;
-                    case parse_result::NoMatch:
-                        return result;
-                    case parse_result::Error:
-                        return result.with(parse_result::NoMatch);
-                    }
-                }
-            }
-        }
-        return parse_result{ currentSource, currentSource == aFragment.cend() || aAtom.tokens().empty() ? parse_result::Consumed : parse_result::NoMatch };
-    }
-
-    compiler::parse_result compiler::parse_token_match(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aMatchResult, const parse_result& aResult, bool aConsumeMatchResult, bool aSelf)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        if (aPass == compiler_pass::Emit)
-        {
-            auto probeResult = parse_token_match(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aMatchResult, aResult, aConsumeMatchResult, aSelf);
-            if (probeResult.action == parse_result::NoMatch)
-                return probeResult;
-        }
-        if (trace() >= 4)
-            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_token_match(" << aAtom.symbol() << ":" << aMatchResult.symbol() << ")" << std::endl;
-        scoped_concept_folder poe{ *this, aPass, postfix_operation_stack() };
-        std::optional<scoped_concept_folder> scs;
-        if (!aSelf)
-            scs.emplace(*this, aPass);
-        parse_result result{ !aAtom.as() || !aAtom.is_conceptually_related_to(aMatchResult) ? aResult : aResult.with_if(aMatchResult)};
-        if (aConsumeMatchResult)
-        {
-            if (aMatchResult.is_concept_atom())
-            {
-                if (aMatchResult.as_concept_atom().get_concept().emit_as() == emit_type::Infix)
-                    result = consume_concept_atom(aPass, aProgram, aUnit, aFragment, aMatchResult, aMatchResult.as_concept_atom().get_concept(), result);
-                else if (aMatchResult.as_concept_atom().get_concept().emit_as() == emit_type::Postfix)
-                    result = consume_concept_atom(aPass, aProgram, aUnit, aFragment, aMatchResult, aMatchResult.as_concept_atom().get_concept(), result, postfix_operation_stack());
-            }
-            else
-                result = consume_token(aPass, aProgram, aUnit, aFragment, aMatchResult, result);
-            if (scs)
-                scs->fold();
-        }
-        if (result.action == parse_result::Consumed)
-        {
-            auto nextMatch = aAtom.find_token(aMatchResult);
-            if (nextMatch != nullptr)
-            {
-                if (*nextMatch != aAtom)
-                {
-                    if (!nextMatch->is_concept_atom())
-                        result = parse_token(aPass, aProgram, aUnit, aFragment, aAtom, *nextMatch, result);
-                    if (result.action == parse_result::Consumed)
-                        result = parse_token_match(aPass, aProgram, aUnit, aFragment, aAtom, *nextMatch, result, true, true);
-                }
-            }
-        }
-        poe.move_to(parse_stack());
-        return result;
-    }
-
-    compiler::parse_result compiler::parse_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aToken, const parse_result& aResult)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        if (aPass == compiler_pass::Emit)
-        {
-            auto probeResult = parse_token(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aToken, aResult);
-            if (probeResult.action == parse_result::NoMatch)
-                return probeResult;
-        }
-        if (trace() >= 4)
-            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_token(" << aAtom.symbol() << ":" << aToken.symbol() << ")" << std::endl;
-        scoped_concept_folder scs{ *this, aPass };
-        if (aToken.is_schema_atom())
-        {
-            if (aToken.as_schema_atom().is_schema_node_atom())
-                return parse(aPass, aProgram, aUnit, aFragment, aToken.as_schema_atom().as_schema_node_atom(), aResult.sourceParsed).with_if(aResult.atom);
-            else if (aToken.as_schema_atom().is_schema_terminal_atom())
-            {
-                auto const& terminal = aToken.as_schema_atom().as_schema_terminal_atom();
-                switch (terminal.type())
-                {
-                case schema_terminal::Default:
-                    break;
-                case schema_terminal::Error:
-                    return aResult.with(parse_result::Error);
-                case schema_terminal::Ignore:
-                    return aResult.with(parse_result::Ignored);
-                case schema_terminal::Continue:
-                    {
-                        auto result = consume_token(aPass, aProgram, aUnit, aFragment, aAtom, aResult);
-                        if (result.action == parse_result::Consumed)
-                            result.action = parse_result::Continue;
-                        return result;
-                    }
-                case schema_terminal::Done:
-                    {
-                        auto result = consume_token(aPass, aProgram, aUnit, aFragment, aAtom, aResult);
-                        if (result.action == parse_result::Consumed)
-                            result.action = parse_result::Done;
-                        return result;
-                    }
-                case schema_terminal::Drain:
-                    return aResult.with(parse_result::Drain);
-                case schema_terminal::Next:
-                    return aResult.with(parse_result::ForNext);
-                case schema_terminal::String:
-                    {
-                        auto const terminalSymbol = terminal.symbol().to_std_string_view();
-                        if (static_cast<std::size_t>(std::distance(aResult.sourceParsed, aFragment.cend())) >= terminalSymbol.size() && std::equal(terminalSymbol.begin(), terminalSymbol.end(), aResult.sourceParsed))
-                            return aResult.with(aResult.sourceParsed + terminalSymbol.size());
-                    }
-                default:
-                    // do nothing
-                    break;
-                }
-            }
-        }
-        else if (aToken.is_concept_atom())
-            return consume_token(aPass, aProgram, aUnit, aFragment, aToken, aResult.with(parse_result::Consumed));
-        return aResult.with(parse_result::NoMatch);
-    }
-
-    compiler::parse_result compiler::consume_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aToken, const parse_result& aResult)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        parse_result result = aResult;
-        if (aToken.is_concept_atom())
-            result = consume_concept_token(aPass, aProgram, aUnit, aFragment, aToken.as_concept_atom().get_concept(), result);
-        else if (aToken.is_schema_atom() && aToken.as_schema_atom().is_schema_node_atom())
-            for (auto& concept_ : aToken.as_schema_atom().as_schema_node_atom().is())
-                if (result.action != parse_result::NoMatch && result.action != parse_result::Ignored && result.action != parse_result::Drain)
-                    result = consume_concept_atom(aPass, aProgram, aUnit, aFragment, aToken, *concept_, result);
-        return result;
-    }
-
-    compiler::parse_result compiler::consume_concept_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_concept& aConcept, const parse_result& aResult)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        auto consumeResult = aConcept.consume_token(aPass, aResult.sourceParsed, aFragment.cend());
-        if (consumeResult.consumed && aPass == compiler_pass::Emit)
-        {
-            if (trace() >= 5)
-                std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "push(token): " << aConcept.name().to_std_string() << " (" << std::string(aResult.sourceParsed, consumeResult.sourceParsed) << ")" << std::endl;
-            parse_stack().push_back(concept_stack_entry{ &aUnit, &aFragment, state().iLevel, &aConcept, aResult.sourceParsed, consumeResult.sourceParsed });
-        }
-        return aResult.with(consumeResult.sourceParsed, consumeResult.consumed ? aResult.action : parse_result::NoMatch);
-    }
-
-    compiler::parse_result compiler::consume_concept_atom(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aAtom, const i_concept& aConcept, const parse_result& aResult)
-    {
-        return consume_concept_atom(aPass, aProgram, aUnit, aFragment, aAtom, aConcept, aResult, parse_stack());
-    }
-        
-    compiler::parse_result compiler::consume_concept_atom(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aAtom, const i_concept& aConcept, const parse_result& aResult, concept_stack_t& aConceptStack)
-    {
-        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
-        auto consumeResult = aConcept.consume_atom(aPass, aAtom, aResult.sourceParsed, aFragment.cend());
-        if (consumeResult.consumed && aPass == compiler_pass::Emit)
-        {
-            if (trace() >= 5)
-                std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "push(atom): " << aConcept.name().to_std_string() << " (" << std::string(aResult.sourceParsed, consumeResult.sourceParsed) << ")" << std::endl;
-            aConceptStack.push_back(concept_stack_entry{ &aUnit, &aFragment, state().iLevel, &aConcept, aResult.sourceParsed, consumeResult.sourceParsed });
-        }
-        return aResult.with(consumeResult.sourceParsed, consumeResult.consumed ? aResult.action : parse_result::NoMatch);
-    }
-
-    bool compiler::fold()
-    {
-        bool didSome = false;
-        bool finished = false;
-        while (!finished)
-        {
-            finished = true;
-            while (fold2())
-            {
-                finished = false;
-                didSome = true;
-            }
-            while (fold1())
-            {
-                finished = false;
-                didSome = true;
-            }
-        }
-        return didSome;
-    }
-
-    bool compiler::fold1()
-    {
-        if (fold_stack().size() < 1)
-            return false;
-        bool didSome = false;
-        std::ostringstream traceOutput;
-        for (auto isingle = fold_stack().begin(); isingle != fold_stack().end();)
-        {
-            auto& single = *isingle;
-            if (single.can_fold())
-            {
-                std::string traceBefore = single.trace();
-                if (trace() >= 1)
-                    traceOutput << "folding: " << traceBefore << " <- " << traceBefore << std::endl;
-                if (!trace_filter() || traceOutput.str().find(*trace_filter()) != std::string::npos)
-                    std::cout << traceOutput.str();
-                traceOutput.str({});
-                single.fold(iContext);
-                if (single.foldedConcept != nullptr)
-                {
-                    if (trace() >= 1)
-                        traceOutput << "folded: " << traceBefore << " <- " << traceBefore << " = " << single.trace() << std::endl;
-                }
-                else
-                {
-                    if (trace() >= 1)
-                        traceOutput << "folded: " << traceBefore << " <- " << traceBefore << " = ()" << std::endl;
-                    isingle = fold_stack().erase(isingle);
-                }
-                if (!trace_filter() || traceOutput.str().find(*trace_filter()) != std::string::npos)
-                    std::cout << traceOutput.str();
-                traceOutput.str({});
-                didSome = true;
-            }
-            else
-                ++isingle;
-        }
-        return didSome;
-    }
-
-    bool compiler::fold2()
-    {
-        if (fold_stack().size() < 2)
-            return false;
-        bool didSome = false;
-        std::ostringstream traceOutput;
-        for (auto irhs = fold_stack().begin(), ilhs = std::next(irhs); ilhs != fold_stack().end();)
-        {
-            auto& rhs = *irhs;
-            auto& lhs = *ilhs;
-            if (lhs.can_fold(rhs))
-            {
-                std::string lhsTraceBefore = lhs.trace();
-                std::string rhsTraceBefore = rhs.trace();
-                if (trace() >= 1)
-                    traceOutput << "folding: " << lhsTraceBefore << " <- " << rhsTraceBefore << std::endl;
-                if (!trace_filter() || traceOutput.str().find(*trace_filter()) != std::string::npos)
-                    std::cout << traceOutput.str();
-                traceOutput.str({});
-                lhs.fold(iContext, rhs);
-                if (trace() >= 1)
-                    traceOutput << "folded: " << lhsTraceBefore << " <- " << rhsTraceBefore << " = " << lhs.trace() << std::endl;
-                if (!trace_filter() || traceOutput.str().find(*trace_filter()) != std::string::npos)
-                    std::cout << traceOutput.str();
-                traceOutput.str({});
-                irhs = fold_stack().erase(irhs);
-                if (irhs != fold_stack().begin())
-                    --irhs;
-                ilhs = std::next(irhs);
-                didSome = true;
-            }
-            else
-                ++irhs, ++ilhs;
-        }
-        return didSome;
-    }
-
-    compiler::concept_stack_t& compiler::parse_stack()
-    {
-        return state().iParseStack;
-    }
-
-    compiler::concept_stack_t& compiler::postfix_operation_stack()
-    {
-        return state().iPostfixOperationStack;
-    }
-
-    compiler::concept_stack_t& compiler::fold_stack()
-    {
-        return state().iFoldStack;
-    }
-
-    void compiler::display_probe_trace(translation_unit& aUnit, const i_source_fragment& aFragment)
-    {
-        std::cout << "Probe trace:-" << std::endl;
-        std::cout << "================" << std::endl;
-        while (std::adjacent_find(
-            state().iDeepestProbe->stacks.begin(),
-            state().iDeepestProbe->stacks.end(),
-            [](auto&& lhs, auto&& rhs) 
-            { 
-                bool match = (!lhs.empty() && !rhs.empty() && lhs.front().atom == rhs.front().atom); 
-                return !match;
-            }) == state().iDeepestProbe->stacks.end())
-        {
-            bool first = true;
-            for (auto& s : state().iDeepestProbe->stacks)
-            {
-                if (first)
-                {
-                    s.front().trace(aUnit, false, trace_filter(), std::cout);
-                    first = false;
-                }
-                s.pop_front();
-            }
-        }
-        for (auto i = state().iDeepestProbe->stacks.begin(); i != state().iDeepestProbe->stacks.end();)
-            if (i->empty())
-                i = state().iDeepestProbe->stacks.erase(i);
-            else
-                ++i;
-        std::cout << "================" << std::endl;
-        for (auto s : state().iDeepestProbe->stacks)
-        {
-            for (auto const& e : s)
-            {
-                e.trace(aUnit, &e == &s.back(), trace_filter(), std::cout);
-            }
-            std::cout << "----------------" << std::endl;
-        }
-    }
-
-    bool compiler::is_finished(const parse_result& aResult)
-    {
-        switch (aResult.action)
-        {
-        case parse_result::ForNext:
-            return true;
-        case parse_result::Done:
-            return true;
-        case parse_result::Drain:
-            return true;
-        default:
-            return false;
-        }
-    }
-
-    bool compiler::finished(parse_result& aResult, bool aConsumeErrors)
-    {
-        switch (aResult.action)
-        {
-        case parse_result::ForNext:
-            aResult.action = parse_result::Consumed;
-            return true;
-        case parse_result::Done:
-            aResult.action = parse_result::Consumed;
-            return true;
-        case parse_result::Drain:
-            aResult.action = parse_result::Consumed;
-            return true;
-        case parse_result::NoMatch:
-            if (aConsumeErrors)
-            {
-                aResult.action = parse_result::Consumed;
-                return true;
-            }
-            return false;
-        case parse_result::Error:
-            if (aConsumeErrors)
-            {
-                aResult.action = parse_result::NoMatch;
-                return true;
-            }
-            return false;
-        default:
-            return false;
-        }
-    }
-
-    std::string compiler::location(const translation_unit& aUnit, const i_source_fragment& aFragment, source_iterator aSourcePos, bool aShowFragmentFilePath)
-    {
-        uint32_t line = 1;
-        uint32_t col = 1;
-        for (auto pos = aFragment.begin(); pos != aSourcePos; ++pos)
-        {
-            if (*pos == '\n')
-            {
-                ++line;
-                col = 1;
-            }
-            else
-                ++col;
-        }
-        return (aShowFragmentFilePath && aFragment.source_file_path() != std::nullopt ? "file '" + *aFragment.source_file_path() + "', " : "") + "line " + boost::lexical_cast<std::string>(line) + ", col " + boost::lexical_cast<std::string>(col);
-    }
-
-    void compiler::throw_error(const translation_unit& aUnit, const i_source_fragment& aFragment, source_iterator aSourcePos, const std::string& aError)
-    {
-        throw std::runtime_error("(" + aError + ") " + location(aUnit, aFragment, aSourcePos));
-    }
-}
+/*
+  compiler.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neolib/neolib.hpp>
+#include <iostream>
+#include <neolib/core/scoped.hpp>
+#include <neolib/core/recursion.hpp>
+#include <neolib/core/string_utf.hpp>
+#include <neos/bytecode/opcodes.hpp>
+#include <neos/bytecode/text.hpp>
+#include <neos/language/compiler.hpp>
+
+namespace neos::language
+{
+    compiler::scoped_concept_folder::scoped_concept_folder(compiler& aCompiler, compiler_pass aPass) :
+        scoped_concept_folder{ aCompiler, aPass, aCompiler.parse_stack() }
+    {
+    }
+
+    compiler::scoped_concept_folder::scoped_concept_folder(compiler& aCompiler, compiler_pass aPass, concept_stack_t& aStack) :
+        iCompiler{ aCompiler }, iPass{ aPass }, iStack{ aStack }, iScopeStart{ aStack.size() }
+    {
+    }
+
+    compiler::scoped_concept_folder::~scoped_concept_folder()
+    {
+        fold();
+    }
+
+    void compiler::scoped_concept_folder::fold()
+    {
+        if (iPass == compiler_pass::Emit)
+            iCompiler.fold(stack().begin() + iScopeStart, stack().end());
+        stack().erase(stack().begin() + iScopeStart, stack().end());
+    }
+
+    void compiler::scoped_concept_folder::move_to(concept_stack_t& aOtherStack)
+    {
+        if (iPass == compiler_pass::Emit)
+            aOtherStack.insert(aOtherStack.end(), stack().begin() + iScopeStart, stack().end());
+        stack().erase(stack().begin() + iScopeStart, stack().end());
+    }
+
+    compiler::concept_stack_t& compiler::scoped_concept_folder::stack()
+    {
+        return iStack;
+    }
+
+    compiler::fold_list::fold_list() :
+        iHead{ None }, iTail{ None }, iSize{ 0u }
+    {
+    }
+
+    bool compiler::fold_list::empty() const
+    {
+        return iSize == 0u;
+    }
+
+    std::size_t compiler::fold_list::size() const
+    {
+        return iSize;
+    }
+
+    compiler::concept_stack_entry& compiler::fold_list::operator[](index_type aIndex)
+    {
+        return iArena[aIndex].entry;
+    }
+
+    compiler::fold_list::index_type compiler::fold_list::previous(index_type aIndex) const
+    {
+        return iArena[aIndex].previous;
+    }
+
+    compiler::fold_list::index_type compiler::fold_list::next(index_type aIndex) const
+    {
+        return iArena[aIndex].next;
+    }
+
+    void compiler::fold_list::push_back(const concept_stack_entry& aEntry)
+    {
+        // no indices are held across push_back so this is where erased slots are reclaimed
+        if (iArena.size() >= CompactThreshold && iArena.size() - iSize > iSize)
+            compact();
+        auto const index = static_cast<index_type>(iArena.size());
+        iArena.push_back(node{ aEntry, iTail, None, false, false });
+        if (iTail != None)
+            iArena[iTail].next = index;
+        else
+            iHead = index;
+        iTail = index;
+        ++iSize;
+        touch(index);
+    }
+
+    void compiler::fold_list::erase(index_type aIndex)
+    {
+        auto& n = iArena[aIndex];
+        if (n.previous != None)
+            iArena[n.previous].next = n.next;
+        else
+            iHead = n.next;
+        if (n.next != None)
+            iArena[n.next].previous = n.previous;
+        else
+            iTail = n.previous;
+        if (n.previous != None)
+            mark_pair(n.previous);
+        n.entry = concept_stack_entry{};
+        n.pairDirty = false;
+        n.singleDirty = false;
+        if (--iSize == 0u)
+        {
+            // nothing pending: reclaim the arena
+            iArena.clear();
+            iHead = None;
+            iTail = None;
+            iDirtyPairs = worklist_t{};
+            iDirtySingles = worklist_t{};
+        }
+    }
+
+    void compiler::fold_list::touch(index_type aIndex, bool aSingle)
+    {
+        if (iArena[aIndex].previous != None)
+            mark_pair(iArena[aIndex].previous);
+        mark_pair(aIndex);
+        if (aSingle && !iArena[aIndex].singleDirty)
+        {
+            iArena[aIndex].singleDirty = true;
+            iDirtySingles.push(aIndex);
+        }
+    }
+
+    bool compiler::fold_list::clean_pair(index_type aIndex)
+    {
+        auto const wasDirty = iArena[aIndex].pairDirty;
+        iArena[aIndex].pairDirty = false;
+        return wasDirty;
+    }
+
+    bool compiler::fold_list::next_dirty_pair(index_type& aIndex)
+    {
+        while (!iDirtyPairs.empty())
+        {
+            aIndex = iDirtyPairs.top();
+            iDirtyPairs.pop();
+            if (clean_pair(aIndex))
+                return true;
+        }
+        return false;
+    }
+
+    bool compiler::fold_list::next_dirty_single(index_type& aIndex)
+    {
+        while (!iDirtySingles.empty())
+        {
+            aIndex = iDirtySingles.top();
+            iDirtySingles.pop();
+            if (iArena[aIndex].singleDirty)
+            {
+                iArena[aIndex].singleDirty = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void compiler::fold_list::compact()
+    {
+        // copy the live nodes in list order so arena order is still stack order, then rebuild the worklists
+        arena_t arena;
+        arena.reserve(iSize);
+        worklist_t dirtyPairs;
+        worklist_t dirtySingles;
+        for (auto i = iHead; i != None; i = iArena[i].next)
+        {
+            auto const index = static_cast<index_type>(arena.size());
+            auto& n = iArena[i];
+            arena.push_back(node{ std::move(n.entry), index == 0u ? None : index - 1u, None, n.pairDirty, n.singleDirty });
+            if (index != 0u)
+                arena[index - 1u].next = index;
+            if (n.pairDirty)
+                dirtyPairs.push(index);
+            if (n.singleDirty)
+                dirtySingles.push(index);
+        }
+        iArena = std::move(arena);
+        iHead = iArena.empty() ? None : 0u;
+        iTail = iArena.empty() ? None : static_cast<index_type>(iArena.size() - 1u);
+        iDirtyPairs = std::move(dirtyPairs);
+        iDirtySingles = std::move(dirtySingles);
+    }
+
+    void compiler::fold_list::mark_pair(index_type aIndex)
+    {
+        if (!iArena[aIndex].pairDirty)
+        {
+            iArena[aIndex].pairDirty = true;
+            iDirtyPairs.push(aIndex);
+        }
+    }
+
+    template <typename Trace>
+    bool compiler::tracing(uint32_t aLevel) const
+    {
+        if constexpr (Trace::enabled)
+            return trace() >= aLevel;
+        else
+            return false;
+    }
+
+    template <typename Function>
+    auto compiler::with_trace_policy(Function aFunction)
+    {
+#ifndef NEOS_NO_COMPILER_TRACE
+        if (trace() != 0u || always_traced() || profiling())
+            return aFunction(runtime_trace{});
+#endif
+        return aFunction(no_trace{});
+    }
+
+    compiler::compiler(i_context& aContext) :
+        iContext{ aContext }, iTrace { 0u }, iAlwaysTraced{ false }, iProfiling{ false }, iMode{ parse_mode::ProbeEmit }, iBackend{ parse_backend::Interpreter }, iStartTime{ std::chrono::steady_clock::now() }, iEndTime{ std::chrono::steady_clock::now() }, 
+        iProbeMemoStats{}, iSpeculationStats{}, iPrunedAlternatives{ 0u }, iScannedCharacters{ 0u }
+    {
+    }
+
+    uint32_t compiler::trace() const
+    {
+        return iTrace;
+    }
+
+    const std::optional<std::string>& compiler::trace_filter() const
+    {
+        return iTraceFilter;
+    }
+
+    void compiler::set_trace(uint32_t aTrace, const std::optional<std::string>& aFilter)
+    {
+        iTrace = aTrace;
+        iTraceFilter = aFilter;
+    }
+
+    bool compiler::always_traced() const
+    {
+        return iAlwaysTraced;
+    }
+
+    void compiler::set_always_traced(bool aAlwaysTraced)
+    {
+        iAlwaysTraced = aAlwaysTraced;
+    }
+
+    bool compiler::profiling() const
+    {
+        return iProfiling;
+    }
+
+    void compiler::set_profiling(bool aProfiling)
+    {
+        iProfiling = aProfiling;
+    }
+
+    const compiler_profile& compiler::profile() const
+    {
+        return iProfile;
+    }
+
+    compiler::parse_mode compiler::mode() const
+    {
+        return iMode;
+    }
+
+    void compiler::set_mode(parse_mode aMode)
+    {
+        iMode = aMode;
+    }
+
+    compiler::parse_backend compiler::backend() const
+    {
+        return iBackend;
+    }
+
+    void compiler::set_backend(parse_backend aBackend)
+    {
+        iBackend = aBackend;
+    }
+
+    const std::chrono::steady_clock::time_point& compiler::start_time() const
+    {
+        return iStartTime;
+    }
+
+    const std::chrono::steady_clock::time_point& compiler::end_time() const
+    {
+        return iEndTime;
+    }
+
+    const compiler::probe_memo_statistics& compiler::probe_memo_stats() const
+    {
+        return iProbeMemoStats;
+    }
+
+    const compiler::speculation_statistics& compiler::speculation_stats() const
+    {
+        return iSpeculationStats;
+    }
+
+    uint64_t compiler::pruned_alternatives() const
+    {
+        return iPrunedAlternatives;
+    }
+
+    uint64_t compiler::scanned_characters() const
+    {
+        return iScannedCharacters;
+    }
+
+    void compiler::compile(program& aProgram)
+    {
+        for (auto& unit : aProgram.translationUnits)
+        {
+            unit.ast.clear();
+            for (auto fragment = unit.fragments.begin(); fragment != unit.fragments.end();)
+                if (fragment->imported())
+                    fragment = unit.fragments.erase(fragment);
+                else
+                    (fragment++)->set_status(compilation_status::Pending);
+        }
+
+        iStartTime = std::chrono::steady_clock::now();
+        iProbeMemoStats = {};
+        iSpeculationStats = {};
+        iPrunedAlternatives = 0u;
+        iScannedCharacters = 0u;
+        iProfile.clear();
+
+        try
+        {
+            for (auto& unit : aProgram.translationUnits)
+                compile(aProgram, unit);
+        }
+        catch(...)
+        {
+            iEndTime = std::chrono::steady_clock::now();
+            throw;
+        }
+
+        iEndTime = std::chrono::steady_clock::now();
+    }
+
+    void compiler::compile(program& aProgram, translation_unit& aUnit)
+    {
+        for (auto& fragment : aUnit.fragments)
+            compile(aProgram, aUnit, fragment);
+    }
+
+    void compiler::compile(program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment)
+    {
+        if (aFragment.status() != compilation_status::Pending)
+            return;
+
+        aFragment.set_status(compilation_status::Compiling);
+            
+        iCompilationStateStack.push_back(std::unique_ptr<compilation_state>(new compilation_state{ &aProgram, &aUnit }));
+
+        auto source = aFragment.cbegin();
+        while (source != aFragment.cend())
+        {
+            state().iDeepestProbe = std::nullopt;
+            auto result = with_trace_policy([&](auto aTrace) 
+            { 
+                return parse<decltype(aTrace)>(compiler_pass::Emit, aProgram, aUnit, aFragment, aUnit.schema->root(), source); 
+            });
+            if (result.action == parse_result::NoMatch)
+            {
+                if (trace() >= 3 && state().iDeepestProbe)
+                    display_probe_trace(aUnit, aFragment);
+                throw_error(aUnit, aFragment, state().iDeepestProbe ? state().iDeepestProbe->source : source, "syntax error");
+            }
+            source = result.sourceParsed;
+        }
+
+        aFragment.set_status(compilation_status::Compiled);
+
+        iCompilationStateStack.pop_back();
+
+        // a nested compilation's nodes can still be adopted by the fragment that started it
+        if (iCompilationStateStack.empty())
+            aUnit.ast.compact();
+    }
+
+    void compiler::compile(const i_source_fragment& aFragment)
+    {
+        auto& program = *state().program;
+        auto& unit = *state().unit;
+        auto& fragment = *unit.fragments.emplace(unit.fragments.end(), aFragment);
+        compile(program, unit, fragment);
+    }
+
+    const compiler::compilation_state& compiler::state() const
+    {
+        return *iCompilationStateStack.back();
+    }
+
+    compiler::compilation_state& compiler::state()
+    {
+        return *iCompilationStateStack.back();
+    }
+
+    template <typename Parser>
+    compiler::parse_result compiler::probe(const probe_memo_key& aKey, Parser aParser)
+    {
+        auto existing = state().iProbeMemo.find(aKey);
+        if (existing != state().iProbeMemo.end())
+        {
+            ++iProbeMemoStats.hits;
+            // the memoized deepest probe keeps the stack traces that reached it, not the current one
+            auto const& deepestProbe = existing->second.deepestProbe;
+            if (deepestProbe && (state().iDeepestProbe == std::nullopt || state().iDeepestProbe->source < deepestProbe->source))
+                state().iDeepestProbe = *deepestProbe;
+            else if (deepestProbe && state().iDeepestProbe->source == deepestProbe->source)
+                state().iDeepestProbe->stacks.insert(state().iDeepestProbe->stacks.end(), deepestProbe->stacks.begin(), deepestProbe->stacks.end());
+            return existing->second.result;
+        }
+        ++iProbeMemoStats.misses;
+        auto const deepestProbeBefore = state().iDeepestProbe ? optional_source_iterator{ state().iDeepestProbe->source } : optional_source_iterator{};
+        auto const result = aParser();
+        std::optional<deepest_probe> deepestProbe;
+        if (state().iDeepestProbe && (!deepestProbeBefore || *deepestProbeBefore < state().iDeepestProbe->source))
+            deepestProbe = state().iDeepestProbe;
+        state().iProbeMemo.emplace(aKey, probe_memo_entry{ result, deepestProbe });
+        return result;
+    }
+
+    template <typename Parser>
+    compiler::parse_result compiler::speculate(Parser aParser)
+    {
+        ++iSpeculationStats.checkpoints;
+        speculation_checkpoint const checkpoint
+        { 
+            parse_stack().size(), 
+            postfix_operation_stack().size(), 
+            state().iSpeculationLog.size(), 
+            state().iDeferredFolds.size(), 
+            state().iDeferredFoldBatches.size() 
+        };
+        auto const result = [&]()
+        {
+            neolib::scoped_counter sc{ state().iSpeculationDepth };
+            return aParser();
+        }();
+        if (result.action == parse_result::NoMatch)
+            rollback(checkpoint);
+        else if (!speculating())
+            commit_speculation();
+        return result;
+    }
+
+    bool compiler::speculating() const
+    {
+        return state().iSpeculationDepth != 0u;
+    }
+
+    void compiler::rollback(const speculation_checkpoint& aCheckpoint)
+    {
+        ++iSpeculationStats.rollbacks;
+        auto& log = state().iSpeculationLog;
+        while (log.size() > aCheckpoint.log)
+        {
+            // only slots that predate the checkpoint survive the truncation below; the operation entries owning them 
+            // enclose this speculation so they are still in place, whereas later slots may have been popped (and 
+            // their indices reused) since their entry was logged
+            auto const& undo = log.back();
+            if (undo.index < aCheckpoint.postfixOperationStack)
+                (*undo.stack)[undo.index].concept_ = undo.concept_;
+            log.pop_back();
+        }
+        parse_stack().erase(parse_stack().begin() + aCheckpoint.parseStack, parse_stack().end());
+        postfix_operation_stack().erase(postfix_operation_stack().begin() + aCheckpoint.postfixOperationStack, postfix_operation_stack().end());
+        state().iDeferredFolds.erase(state().iDeferredFolds.begin() + aCheckpoint.deferredFolds, state().iDeferredFolds.end());
+        state().iDeferredFoldBatches.erase(state().iDeferredFoldBatches.begin() + aCheckpoint.deferredFoldBatches, state().iDeferredFoldBatches.end());
+    }
+
+    void compiler::commit_speculation()
+    {
+        state().iSpeculationLog.clear();
+        concept_stack_t deferredFolds;
+        fold_batches_t deferredFoldBatches;
+        deferredFolds.swap(state().iDeferredFolds);
+        deferredFoldBatches.swap(state().iDeferredFoldBatches);
+        auto batchStart = deferredFolds.cbegin();
+        for (auto batchEnd : deferredFoldBatches)
+        {
+            fold(batchStart, deferredFolds.cbegin() + batchEnd);
+            batchStart = deferredFolds.cbegin() + batchEnd;
+        }
+    }
+
+    template <typename Trace, typename Parser>
+    compiler::parse_result compiler::profiled(compiler_profile::parser aParser, compiler_pass aPass, const i_schema_node_atom& aAtom, source_iterator aSource, Parser aParse)
+    {
+        if constexpr (Trace::enabled)
+        {
+            if (profiling())
+            {
+                iProfile.enter(aAtom);
+                auto const result = aParse();
+                bool const matched = result.action != parse_result::NoMatch && result.action != parse_result::Error;
+                iProfile.leave(aParser, aPass, matched, matched ? static_cast<std::size_t>(std::distance(aSource, result.sourceParsed)) : 0u);
+                return result;
+            }
+        }
+        return aParse();
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::parse(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, source_iterator aSource)
+    {
+        return profiled<Trace>(compiler_profile::parser::Parse, aPass, aAtom, aSource, [&]()
+        {
+            if (aPass == compiler_pass::Probe)
+                return probe(probe_memo_key{ probe_memo_key::Parse, &aAtom, nullptr, nullptr, std::distance(aFragment.cbegin(), aSource), 0u },
+                    [&]() { return do_parse<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aSource); });
+            if (mode() == parse_mode::Speculative)
+                return speculate([&]() { return do_parse<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aSource); });
+            auto probeResult = parse<Trace>(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aSource);
+            if (probeResult.action == parse_result::NoMatch)
+                return probeResult;
+            return do_parse<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aSource);
+        });
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::do_parse(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, source_iterator aSource)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        neolib::scoped_counter sc{ state().iLevel };
+        scoped_stack_trace<Trace> sst{ *this, aAtom, aSource, "parse" };
+        if (tracing<Trace>(4))
+            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse(" << aAtom.symbol() << ")" << std::endl;
+        scoped_concept_folder scs{ *this, aPass };
+        bool const expectingToken = !aAtom.expects().empty();
+        if (aSource != aFragment.cend())
+        {
+            if (expectingToken)
+            {
+                for (auto const& expect : aAtom.expects())
+                {
+                    auto recursiveLevel = aAtom.recursive_token(*expect);
+                    if (aAtom.expects().size() == 1 && recursiveLevel != 0u)
+                    {
+                        if (aPass == compiler_pass::Emit && postfix_operation_stack().size() >= 2)
+                        {
+                            auto const& current = *std::prev(postfix_operation_stack().end());
+                            auto& previous = *std::prev(std::prev(postfix_operation_stack().end()));
+                            if (current.level == previous.level + recursiveLevel && previous.concept_ != nullptr &&
+                                aAtom.token().is_conceptually_related_to(*current.concept_) &&
+                                aAtom.token().is_conceptually_related_to(*previous.concept_))
+                            {
+                                parse_stack().push_back(previous);
+                                scs.fold();
+                                if (speculating())
+                                    state().iSpeculationLog.push_back(speculation_undo{ &postfix_operation_stack(), postfix_operation_stack().size() - 2u, previous.concept_ });
+                                previous.concept_ = nullptr;
+                            }
+                        }
+                    }
+                    auto result = parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, expected{ &*expect, &aAtom }, aSource);
+                    if (is_finished(result) || result.action == parse_result::Consumed)
+                        return result;
+                    if (state().iDeepestProbe == std::nullopt || state().iDeepestProbe->source < result.sourceParsed)
+                        state().iDeepestProbe = deepest_probe{ result.sourceParsed, { state().iStackTrace } };
+                    else if (state().iDeepestProbe->source == result.sourceParsed)
+                        state().iDeepestProbe->stacks.push_back(state().iStackTrace);
+                }
+                return parse_result{ aSource, parse_result::NoMatch };
+            }
+            else
+                return parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, expected{}, aSource);
+        }
+        else
+            return expectingToken ? parse_result{ aSource, parse_result::NoMatch } : parse_result{ aSource };
+        //auto loop = emit(aProgram.text, bytecode::opcode::ADD, bytecode::registers::R1, bytecode::u64{ 10 });
+        //emit(aProgram.text, bytecode::opcode::ADD, bytecode::registers::R1, bytecode::i8{ -1 });
+        //emit(aProgram.text, bytecode::opcode::B, loop);
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::parse_tokens(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const expected& aExpected, source_iterator aSource)
+    {
+        return profiled<Trace>(compiler_profile::parser::ParseTokens, aPass, aAtom, aSource, [&]()
+        {
+            if (aPass == compiler_pass::Probe)
+                return probe(probe_memo_key{ probe_memo_key::ParseTokens, &aAtom, aExpected.what, aExpected.context, std::distance(aFragment.cbegin(), aSource), aExpected.consumed ? 1u : 0u },
+                    [&]() { return do_parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aExpected, aSource); });
+            if (mode() == parse_mode::Speculative)
+                return speculate([&]() { return do_parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aExpected, aSource); });
+            auto probeResult = parse_tokens<Trace>(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aExpected, aSource);
+            if (probeResult.action == parse_result::NoMatch)
+                return probeResult;
+            return do_parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aExpected, aSource);
+        });
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::do_parse_tokens(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const expected& aExpected, source_iterator aSource)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        if (tracing<Trace>(4))
+            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_tokens(" << aAtom.symbol() << ")" << std::endl;
+        scoped_concept_folder scs{ *this, aPass };
+        auto currentSource = aSource;
+        bool defaultOk = aAtom.expect_none();
+        auto expectedAtom = aExpected.what;
+        auto expectedConsumed = aExpected.consumed;
+        bool const consumeSelf = (expectedAtom == nullptr || *aExpected.context == aAtom);
+        bool handledExpect = false;
+        if (expectedAtom && expectedAtom->is_schema_atom() && expectedAtom->as_schema_atom().is_schema_node_atom() &&
+            expectedAtom->as_schema_atom().as_schema_node_atom().as())
+        {
+            auto result = parse<Trace>(aPass, aProgram, aUnit, aFragment, expectedAtom->as_schema_atom().as_schema_node_atom(), currentSource);
+            if (is_finished(result))
+            {
+                currentSource = result.sourceParsed;
+                expectedAtom = result.atom;
+                expectedConsumed = true;
+            }
+        }
+        auto iterToken = expectedAtom ?
+            std::find_if(aAtom.tokens().begin(), aAtom.tokens().end(), [expectedAtom](auto&& tokensEntry)
+            { 
+                auto const& token = *tokensEntry.first();
+                return *expectedAtom == token;
+            }) : 
+            aAtom.tokens().begin();
+        if (expectedAtom && iterToken == aAtom.tokens().end())
+        {
+            iterToken = expectedAtom ?
+                std::find_if(aAtom.tokens().begin(), aAtom.tokens().end(), [expectedAtom](auto&& tokensEntry)
+                { 
+                    auto const& token = *tokensEntry.first();
+                    return expectedAtom->is_conceptually_related_to(token);
+                }) : 
+                aAtom.tokens().begin();
+        }
+        if (expectedAtom && iterToken == aAtom.tokens().end())
+        {
+            if (aAtom.has_parent())
+                return parse_tokens<Trace>(aPass, aProgram, aUnit, aFragment, aAtom.parent().as_schema_atom().as_schema_node_atom(), aExpected, aSource);
+            return parse_result{ aSource, parse_result::NoMatch };
+        }
+        bool skipConsume = (expectedAtom && expectedConsumed);
+        auto const tableNode = backend() == parse_backend::Table ? aUnit.schema->parse_table().find(aAtom) : nullptr;
+        bool const predictive = tableNode != nullptr && tableNode->deterministic;
+        for (; currentSource != aFragment.cend() && iterToken != aAtom.tokens().end();)
+        {
+            if (tableNode != nullptr && !tracing<Trace>(4) && !skipConsume && (handledExpect || !aExpected.what) && iterToken == aAtom.tokens().begin() &&
+                tableNode->run.characters().test(*currentSource))
+            {
+                // a run of single character class tokens that continue this node is consumed in one step rather than 
+                // by a parse_token round trip per character; the emit pass still pushes and folds each character
+                auto const run = &*currentSource;
+                auto const runEnd = std::next(currentSource, tableNode->run.scan(run, run + std::distance(currentSource, aFragment.cend())));
+                iScannedCharacters += std::distance(currentSource, runEnd);
+                if (aPass == compiler_pass::Emit)
+                    for (; currentSource != runEnd; ++currentSource)
+                    {
+                        scoped_concept_folder tokenScs{ *this, aPass };
+                        consume_concept_token<Trace>(aPass, aProgram, aUnit, aFragment, 
+                            aUnit.schema->parse_table().candidate(*tableNode, *currentSource).as_concept_atom().get_concept(), parse_result{ currentSource, parse_result::Consumed });
+                    }
+                else
+                    currentSource = runEnd;
+                defaultOk = true;
+                handledExpect = true;
+                continue;
+            }
+            if (predictive && !skipConsume && (handledExpect || !aExpected.what) && iterToken == aAtom.tokens().begin())
+            {
+                auto const& predicted = aUnit.schema->parse_table().predict(*tableNode, *currentSource);
+                for (; &*iterToken->first() != &predicted; ++iterToken)
+                    ++iPrunedAlternatives;
+            }
+            auto const& token = *iterToken->first();
+            auto const& tokenValue = *iterToken->second();
+            if (aAtom.is_token_node() && aAtom.token() == token)
+                defaultOk = true;
+            parse_result result{ currentSource };
+            if (!skipConsume)
+            {
+                if (token.first_characters().test(*currentSource))
+                    result = parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, token, result);
+                else
+                {
+                    ++iPrunedAlternatives;
+                    result = result.with(parse_result::NoMatch);
+                }
+            }
+            skipConsume = false;
+            if (finished(result))
+            {
+                if (aAtom.as() && aAtom.is_conceptually_related_to(tokenValue))
+                    result.atom = &token;
+                if (token.is_schema_atom() && token.as_schema_atom().is_schema_node_atom() && token.as_schema_atom().as_schema_node_atom().is_token_node())
+                    return consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, result);
+            }
+            bool const ateSome = (result.action == parse_result::Consumed);
+            if (ateSome)
+            {
+                defaultOk = true;
+                auto const& matchedTokenValue = tokenValue;
+                if (!matchedTokenValue.is_schema_atom() || matchedTokenValue.as_schema_atom().is_schema_node_atom())
+                {
+                    if (aAtom.is_parent_of(matchedTokenValue) || aAtom.is_sibling_of(matchedTokenValue))
+                        result = parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
+                    if (aAtom.as() && aAtom.is_conceptually_related_to(matchedTokenValue))
+                        result.atom = &matchedTokenValue;
+                    if (is_finished(result))
+                    {
+                        if (consumeSelf)
+                            result = consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, result);
+                        if (aAtom.is_parent_of(matchedTokenValue))
+                            return result;
+                        if (consumeSelf && result.action == parse_result::Done)
+                            finished(result);
+                    }
+                    if (result.action == parse_result::Consumed)
+                    {
+                        if (matchedTokenValue.is_concept_atom())
+                        {
+                            result = parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
+                            if (is_finished(result))
+                                return consumeSelf ? consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
+                        }
+                        else
+                        {
+                            result = parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, matchedTokenValue.as_schema_atom().as_schema_node_atom(), token, result, false);
+                            if (is_finished(result))
+                            {
+                                result = consume_token<Trace>(aPass, aProgram, aUnit, aFragment, matchedTokenValue, result);
+                                return consumeSelf ? consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
+                            }
+                            if (result.action == parse_result::Consumed)
+                            {
+                                result = parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result, aAtom.is_parent_of(matchedTokenValue));
+                                if (is_finished(result))
+                                    return consumeSelf ? consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, result) : result;
+                            }
+                        }
+                        if (result.action == parse_result::Consumed)
+                        {
+                            currentSource = result.sourceParsed;
+                            iterToken = aAtom.tokens().begin();
+                        }
+                        else if (is_finished(result))
+                            return result;
+                        else
+                            ++iterToken;
+                    }
+                    else if (result.action == parse_result::Consumed)
+                        ++iterToken;
+                    else
+                        return result;
+                }
+                else if (matchedTokenValue.is_schema_atom() && matchedTokenValue.as_schema_atom().is_schema_terminal_atom())
+                {
+                    result = parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, matchedTokenValue, result);
+                    switch(result.action)
+                    {
+                    case parse_result::Drain:
+                    case parse_result::Done:
+                    case parse_result::ForNext:
+                        return result;
+                    case parse_result::Ignored:
+                    case parse_result::Continue:
+                        currentSource = result.sourceParsed;
+                        iterToken = aAtom.tokens().begin();
+                        break;
+                    case parse_result::NoMatch:
+                        if (token.is_schema_atom() && token.as_schema_atom().is_schema_terminal_atom() && token.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::String)
+                            result.sourceParsed = std::prev(result.sourceParsed, token.symbol().size());
+                        return result;
+                    case parse_result::Error:
+                        return parse_result{ result.sourceParsed, parse_result::NoMatch };
+                    default:
+                        /* do nothing */
+                        break;
+                    }
+                }
+                else
+                    return result;
+            }
+            else
+            {
+                if (!handledExpect && aExpected.what)
+                    return parse_result{ aSource, parse_result::NoMatch };
+                ++iterToken;
+            }
+            handledExpect = true;
+            if (iterToken == aAtom.tokens().end())
+            {
+                if (token.is_schema_atom() && token.as_schema_atom().is_schema_terminal_atom() &&
+                    token.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::Default)
+                {
+                    auto result = parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, tokenValue, parse_result{ currentSource });
+                    switch (result.action)
+                    {
+                    case parse_result::Drain:
+                    case parse_result::Done:
+                    case parse_result::ForNext:
+                        return defaultOk ? result : result.with(parse_result::NoMatch);
+                    case parse_result::Consumed:
+                        currentSource = result.sourceParsed;
+                        break;
+                    case parse_result::Ignored:
+                        if (!ateSome && currentSource == result.sourceParsed)
+                            ++currentSource;
+                        iterToken = aAtom.tokens().begin();
+                        break;
+                    case parse_result::NoMatch:
+                        return result;
+                    case parse_result::Error:
+                        return result.with(parse_result::NoMatch);
+                    }
+                }
+            }
+        }
+        return parse_result{ currentSource, currentSource == aFragment.cend() || aAtom.tokens().empty() ? parse_result::Consumed : parse_result::NoMatch };
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::parse_token_match(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aMatchResult, const parse_result& aResult, bool aConsumeMatchResult, bool aSelf)
+    {
+        if (aPass == compiler_pass::Probe)
+            return probe(probe_memo_key{ probe_memo_key::ParseTokenMatch, &aAtom, &aMatchResult, aResult.atom, std::distance(aFragment.cbegin(), aResult.sourceParsed), 
+                static_cast<uint32_t>(aResult.action) | (aConsumeMatchResult ? 0x100u : 0u) | (aSelf ? 0x200u : 0u) },
+                [&]() { return do_parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aMatchResult, aResult, aConsumeMatchResult, aSelf); });
+        if (mode() == parse_mode::Speculative)
+            return speculate([&]() { return do_parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aMatchResult, aResult, aConsumeMatchResult, aSelf); });
+        auto probeResult = parse_token_match<Trace>(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aMatchResult, aResult, aConsumeMatchResult, aSelf);
+        if (probeResult.action == parse_result::NoMatch)
+            return probeResult;
+        return do_parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aMatchResult, aResult, aConsumeMatchResult, aSelf);
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::do_parse_token_match(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aMatchResult, const parse_result& aResult, bool aConsumeMatchResult, bool aSelf)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        if (tracing<Trace>(4))
+            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_token_match(" << aAtom.symbol() << ":" << aMatchResult.symbol() << ")" << std::endl;
+        scoped_concept_folder poe{ *this, aPass, postfix_operation_stack() };
+        std::optional<scoped_concept_folder> scs;
+        if (!aSelf)
+            scs.emplace(*this, aPass);
+        parse_result result{ !aAtom.as() || !aAtom.is_conceptually_related_to(aMatchResult) ? aResult : aResult.with_if(aMatchResult)};
+        if (aConsumeMatchResult)
+        {
+            if (aMatchResult.is_concept_atom())
+            {
+                if (aMatchResult.as_concept_atom().get_concept().emit_as() == emit_type::Infix)
+                    result = consume_concept_atom<Trace>(aPass, aProgram, aUnit, aFragment, aMatchResult, aMatchResult.as_concept_atom().get_concept(), result);
+                else if (aMatchResult.as_concept_atom().get_concept().emit_as() == emit_type::Postfix)
+                    result = consume_concept_atom<Trace>(aPass, aProgram, aUnit, aFragment, aMatchResult, aMatchResult.as_concept_atom().get_concept(), result, postfix_operation_stack());
+            }
+            else
+                result = consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aMatchResult, result);
+            if (scs)
+                scs->fold();
+        }
+        if (result.action == parse_result::Consumed)
+        {
+            auto nextMatch = aAtom.find_token(aMatchResult);
+            if (nextMatch != nullptr)
+            {
+                if (*nextMatch != aAtom)
+                {
+                    if (!nextMatch->is_concept_atom())
+                        result = parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, *nextMatch, result);
+                    if (result.action == parse_result::Consumed)
+                        result = parse_token_match<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, *nextMatch, result, true, true);
+                }
+            }
+        }
+        poe.move_to(parse_stack());
+        return result;
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::parse_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aToken, const parse_result& aResult)
+    {
+        if (aPass == compiler_pass::Probe)
+            return probe(probe_memo_key{ probe_memo_key::ParseToken, &aAtom, &aToken, aResult.atom, std::distance(aFragment.cbegin(), aResult.sourceParsed), static_cast<uint32_t>(aResult.action) },
+                [&]() { return do_parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aToken, aResult); });
+        if (mode() == parse_mode::Speculative)
+            return speculate([&]() { return do_parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aToken, aResult); });
+        auto probeResult = parse_token<Trace>(compiler_pass::Probe, aProgram, aUnit, aFragment, aAtom, aToken, aResult);
+        if (probeResult.action == parse_result::NoMatch)
+            return probeResult;
+        return do_parse_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aToken, aResult);
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::do_parse_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_schema_node_atom& aAtom, const i_atom& aToken, const parse_result& aResult)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        if (tracing<Trace>(4))
+            std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "parse_token(" << aAtom.symbol() << ":" << aToken.symbol() << ")" << std::endl;
+        scoped_concept_folder scs{ *this, aPass };
+        if (aToken.is_schema_atom())
+        {
+            if (aToken.as_schema_atom().is_schema_node_atom())
+                return parse<Trace>(aPass, aProgram, aUnit, aFragment, aToken.as_schema_atom().as_schema_node_atom(), aResult.sourceParsed).with_if(aResult.atom);
+            else if (aToken.as_schema_atom().is_schema_terminal_atom())
+            {
+                auto const& terminal = aToken.as_schema_atom().as_schema_terminal_atom();
+                switch (terminal.type())
+                {
+                case schema_terminal::Default:
+                    break;
+                case schema_terminal::Error:
+                    return aResult.with(parse_result::Error);
+                case schema_terminal::Ignore:
+                    return aResult.with(parse_result::Ignored);
+                case schema_terminal::Continue:
+                    {
+                        auto result = consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aResult);
+                        if (result.action == parse_result::Consumed)
+                            result.action = parse_result::Continue;
+                        return result;
+                    }
+                case schema_terminal::Done:
+                    {
+                        auto result = consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aResult);
+                        if (result.action == parse_result::Consumed)
+                            result.action = parse_result::Done;
+                        return result;
+                    }
+                case schema_terminal::Drain:
+                    return aResult.with(parse_result::Drain);
+                case schema_terminal::Next:
+                    return aResult.with(parse_result::ForNext);
+                case schema_terminal::String:
+                    {
+                        auto const terminalSymbol = terminal.symbol().to_std_string_view();
+                        if (static_cast<std::size_t>(std::distance(aResult.sourceParsed, aFragment.cend())) >= terminalSymbol.size() && std::equal(terminalSymbol.begin(), terminalSymbol.end(), aResult.sourceParsed))
+                            return aResult.with(aResult.sourceParsed + terminalSymbol.size());
+                    }
+                default:
+                    // do nothing
+                    break;
+                }
+            }
+        }
+        else if (aToken.is_concept_atom())
+            return consume_token<Trace>(aPass, aProgram, aUnit, aFragment, aToken, aResult.with(parse_result::Consumed));
+        return aResult.with(parse_result::NoMatch);
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::consume_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aToken, const parse_result& aResult)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        parse_result result = aResult;
+        if (aToken.is_concept_atom())
+            result = consume_concept_token<Trace>(aPass, aProgram, aUnit, aFragment, aToken.as_concept_atom().get_concept(), result);
+        else if (aToken.is_schema_atom() && aToken.as_schema_atom().is_schema_node_atom())
+            for (auto& concept_ : aToken.as_schema_atom().as_schema_node_atom().is())
+                if (result.action != parse_result::NoMatch && result.action != parse_result::Ignored && result.action != parse_result::Drain)
+                    result = consume_concept_atom<Trace>(aPass, aProgram, aUnit, aFragment, aToken, *concept_, result);
+        return result;
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::consume_concept_token(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_concept& aConcept, const parse_result& aResult)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        auto consumeResult = aConcept.consume_token(aPass, aResult.sourceParsed, aFragment.cend());
+        if (consumeResult.consumed && aPass == compiler_pass::Emit)
+        {
+            if (tracing<Trace>(5))
+                std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "push(token): " << aConcept.name().to_std_string() << " (" << std::string(aResult.sourceParsed, consumeResult.sourceParsed) << ")" << std::endl;
+            parse_stack().push_back(concept_stack_entry{ &aUnit, &aFragment, state().iLevel, &aConcept, aResult.sourceParsed, consumeResult.sourceParsed });
+        }
+        return aResult.with(consumeResult.sourceParsed, consumeResult.consumed ? aResult.action : parse_result::NoMatch);
+    }
+
+    template <typename Trace>
+    compiler::parse_result compiler::consume_concept_atom(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aAtom, const i_concept& aConcept, const parse_result& aResult)
+    {
+        return consume_concept_atom<Trace>(aPass, aProgram, aUnit, aFragment, aAtom, aConcept, aResult, parse_stack());
+    }
+        
+    template <typename Trace>
+    compiler::parse_result compiler::consume_concept_atom(compiler_pass aPass, program& aProgram, translation_unit& aUnit, i_source_fragment& aFragment, const i_atom& aAtom, const i_concept& aConcept, const parse_result& aResult, concept_stack_t& aConceptStack)
+    {
+        _limit_recursion_to_(compiler, aUnit.schema->meta().parserRecursionLimit);
+        auto consumeResult = aConcept.consume_atom(aPass, aAtom, aResult.sourceParsed, aFragment.cend());
+        if (consumeResult.consumed && aPass == compiler_pass::Emit)
+        {
+            if (tracing<Trace>(5))
+                std::cout << std::string(_compiler_recursion_limiter_.depth(), ' ') << "push(atom): " << aConcept.name().to_std_string() << " (" << std::string(aResult.sourceParsed, consumeResult.sourceParsed) << ")" << std::endl;
+            aConceptStack.push_back(concept_stack_entry{ &aUnit, &aFragment, state().iLevel, &aConcept, aResult.sourceParsed, consumeResult.sourceParsed });
+        }
+        return aResult.with(consumeResult.sourceParsed, consumeResult.consumed ? aResult.action : parse_result::NoMatch);
+    }
+
+    void compiler::fold(concept_stack_t::const_iterator aFirst, concept_stack_t::const_iterator aLast)
+    {
+        with_trace_policy([&](auto aTrace) { do_fold<decltype(aTrace)>(aFirst, aLast); });
+    }
+
+    template <typename Trace>
+    void compiler::do_fold(concept_stack_t::const_iterator aFirst, concept_stack_t::const_iterator aLast)
+    {
+        if (speculating())
+        {
+            // folding mutates concept instances so it cannot be undone; defer it until the outermost speculation succeeds
+            if (aFirst != aLast)
+            {
+                state().iDeferredFolds.insert(state().iDeferredFolds.end(), aFirst, aLast);
+                state().iDeferredFoldBatches.push_back(state().iDeferredFolds.size());
+            }
+            return;
+        }
+        std::for_each(aFirst, aLast,
+            [this](const concept_stack_entry& aEntry)
+            {
+                if (aEntry.concept_ != nullptr)
+                {
+                    auto entry = aEntry;
+                    entry.astNode = aEntry.unit->ast.add(*aEntry.concept_, *aEntry.fragment,
+                        static_cast<uint32_t>(std::distance(aEntry.fragment->cbegin(), aEntry.sourceStart)),
+                        static_cast<uint32_t>(std::distance(aEntry.fragment->cbegin(), aEntry.sourceEnd)));
+                    fold_stack().push_back(entry);
+                    if (tracing<Trace>(2))
+                        std::cout << "prefold: " << "<" << aEntry.level << ": " << location(*aEntry.unit, *aEntry.fragment, aEntry.sourceStart, false) << "> "
+                            << aEntry.concept_->name() << " (" << std::string(aEntry.sourceStart, aEntry.sourceEnd) << ")" << std::endl;
+                }
+            });
+        fold<Trace>();
+    }
+
+    template <typename Trace>
+    bool compiler::fold()
+    {
+        bool didSome = false;
+        bool finished = false;
+        while (!finished)
+        {
+            finished = true;
+            while (fold2<Trace>())
+            {
+                finished = false;
+                didSome = true;
+            }
+            while (fold1<Trace>())
+            {
+                finished = false;
+                didSome = true;
+            }
+        }
+        return didSome;
+    }
+
+    template <typename Trace>
+    bool compiler::fold1()
+    {
+        auto& stack = fold_stack();
+        bool didSome = false;
+        for (fold_list::index_type isingle; stack.next_dirty_single(isingle);)
+        {
+            for (bool erased = false; !erased && stack[isingle].can_fold();)
+            {
+                auto& single = stack[isingle];
+                std::string traceBefore;
+                if constexpr (Trace::enabled)
+                {
+                    traceBefore = single.trace();
+                    if (tracing<Trace>(1))
+                        trace_fold("folding: " + traceBefore + " <- " + traceBefore);
+                    if (profiling())
+                    {
+                        if (!single.foldedConcept)
+                            iProfile.instantiated(*single.concept_);
+                        iProfile.folded(*single.concept_);
+                    }
+                }
+                single.fold(iContext);
+                if (single.foldedConcept != nullptr)
+                {
+                    if (tracing<Trace>(1))
+                        trace_fold("folded: " + traceBefore + " <- " + traceBefore + " = " + single.trace());
+                    stack.touch(isingle, false);
+                }
+                else
+                {
+                    if (tracing<Trace>(1))
+                        trace_fold("folded: " + traceBefore + " <- " + traceBefore + " = ()");
+                    stack.erase(isingle);
+                    erased = true;
+                }
+                didSome = true;
+            }
+        }
+        return didSome;
+    }
+
+    template <typename Trace>
+    bool compiler::fold2()
+    {
+        auto& stack = fold_stack();
+        bool didSome = false;
+        // same cursor as a full left to right scan that steps back after each fold; clean pairs are skipped
+        for (fold_list::index_type irhs; stack.next_dirty_pair(irhs);)
+        {
+            for (auto ilhs = stack.next(irhs); ilhs != fold_list::None; ilhs = stack.next(irhs))
+            {
+                auto& rhs = stack[irhs];
+                auto& lhs = stack[ilhs];
+                if (lhs.can_fold(rhs))
+                {
+                    std::string lhsTraceBefore;
+                    std::string rhsTraceBefore;
+                    if constexpr (Trace::enabled)
+                    {
+                        lhsTraceBefore = lhs.trace();
+                        rhsTraceBefore = rhs.trace();
+                        if (tracing<Trace>(1))
+                            trace_fold("folding: " + lhsTraceBefore + " <- " + rhsTraceBefore);
+                        if (profiling())
+                        {
+                            if (rhs.can_fold())
+                            {
+                                if (!rhs.foldedConcept)
+                                    iProfile.instantiated(*rhs.concept_);
+                                iProfile.folded(*rhs.concept_);
+                            }
+                            if (!lhs.foldedConcept)
+                                iProfile.instantiated(*lhs.concept_);
+                            iProfile.folded(*lhs.concept_);
+                        }
+                    }
+                    lhs.fold(iContext, rhs);
+                    if (tracing<Trace>(1))
+                        trace_fold("folded: " + lhsTraceBefore + " <- " + rhsTraceBefore + " = " + lhs.trace());
+                    if (rhs.foldedConcept)
+                        rhs.unit->ast.resolve(rhs.astNode, *rhs.foldedConcept);
+                    lhs.unit->ast.adopt(lhs.astNode, rhs.astNode);
+                    auto const previous = stack.previous(irhs);
+                    stack.erase(irhs);
+                    stack.touch(ilhs);
+                    irhs = previous != fold_list::None ? previous : ilhs;
+                    stack.clean_pair(irhs);
+                    didSome = true;
+                }
+                else if (stack.clean_pair(ilhs))
+                    irhs = ilhs;
+                else
+                    break;
+            }
+        }
+        return didSome;
+    }
+
+    void compiler::trace_fold(const std::string& aLine) const
+    {
+        if (!trace_filter() || aLine.find(*trace_filter()) != std::string::npos)
+            std::cout << aLine << std::endl;
+    }
+
+    compiler::concept_stack_t& compiler::parse_stack()
+    {
+        return state().iParseStack;
+    }
+
+    compiler::concept_stack_t& compiler::postfix_operation_stack()
+    {
+        return state().iPostfixOperationStack;
+    }
+
+    compiler::fold_list& compiler::fold_stack()
+    {
+        return state().iFoldStack;
+    }
+
+    void compiler::display_probe_trace(translation_unit& aUnit, const i_source_fragment& aFragment)
+    {
+        std::cout << "Probe trace:-" << std::endl;
+        std::cout << "================" << std::endl;
+        while (std::adjacent_find(
+            state().iDeepestProbe->stacks.begin(),
+            state().iDeepestProbe->stacks.end(),
+            [](auto&& lhs, auto&& rhs) 
+            { 
+                bool match = (!lhs.empty() && !rhs.empty() && lhs.front().atom == rhs.front().atom); 
+                return !match;
+            }) == state().iDeepestProbe->stacks.end())
+        {
+            bool first = true;
+            for (auto& s : state().iDeepestProbe->stacks)
+            {
+                if (first)
+                {
+                    s.front().trace(aUnit, false, trace_filter(), std::cout);
+                    first = false;
+                }
+                s.pop_front();
+            }
+        }
+        for (auto i = state().iDeepestProbe->stacks.begin(); i != state().iDeepestProbe->stacks.end();)
+            if (i->empty())
+                i = state().iDeepestProbe->stacks.erase(i);
+            else
+                ++i;
+        std::cout << "================" << std::endl;
+        for (auto s : state().iDeepestProbe->stacks)
+        {
+            for (auto const& e : s)
+            {
+                e.trace(aUnit, &e == &s.back(), trace_filter(), std::cout);
+            }
+            std::cout << "----------------" << std::endl;
+        }
+    }
+
+    bool compiler::is_finished(const parse_result& aResult)
+    {
+        switch (aResult.action)
+        {
+        case parse_result::ForNext:
+            return true;
+        case parse_result::Done:
+            return true;
+        case parse_result::Drain:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool compiler::finished(parse_result& aResult, bool aConsumeErrors)
+    {
+        switch (aResult.action)
+        {
+        case parse_result::ForNext:
+            aResult.action = parse_result::Consumed;
+            return true;
+        case parse_result::Done:
+            aResult.action = parse_result::Consumed;
+            return true;
+        case parse_result::Drain:
+            aResult.action = parse_result::Consumed;
+            return true;
+        case parse_result::NoMatch:
+            if (aConsumeErrors)
+            {
+                aResult.action = parse_result::Consumed;
+                return true;
+            }
+            return false;
+        case parse_result::Error:
+            if (aConsumeErrors)
+            {
+                aResult.action = parse_result::NoMatch;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    std::string compiler::location(const translation_unit& aUnit, const i_source_fragment& aFragment, source_iterator aSourcePos, bool aShowFragmentFilePath)
+    {
+        uint32_t line = 1;
+        uint32_t col = 1;
+        for (auto pos = aFragment.begin(); pos != aSourcePos; ++pos)
+        {
+            if (*pos == '\n')
+            {
+                ++line;
+                col = 1;
+            }
+            else
+                ++col;
+        }
+        return (aShowFragmentFilePath && aFragment.source_file_path() != std::nullopt ? "file '" + *aFragment.source_file_path() + "', " : "") + "line " + boost::lexical_cast<std::string>(line) + ", col " + boost::lexical_cast<std::string>(col);
+    }
+
+    void compiler::throw_error(const translation_unit& aUnit, const i_source_fragment& aFragment, source_iterator aSourcePos, const std::string& aError)
+    {
+        throw std::runtime_error("(" + aError + ") " + location(aUnit, aFragment, aSourcePos));
+    }
+}
@@ -0,0 +1,209 @@
+/*
+  compiler_profile.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <neos/language/compiler_profile.hpp>
+
+namespace neos::language
+{
+    namespace
+    {
+        std::string json_escaped(const std::string& aText)
+        {
+            std::string result;
+            for (auto ch : aText)
+            {
+                if (static_cast<unsigned char>(ch) < 0x20u)
+                {
+                    std::ostringstream hex;
+                    hex << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<uint32_t>(static_cast<unsigned char>(ch));
+                    result += hex.str();
+                    continue;
+                }
+                if (ch == '\\' || ch == '"')
+                    result += '\\';
+                result += ch;
+            }
+            return result;
+        }
+
+        double milliseconds(std::chrono::nanoseconds aTime)
+        {
+            return std::chrono::duration<double, std::milli>{ aTime }.count();
+        }
+    }
+
+    bool compiler_profile::empty() const
+    {
+        return iRules.empty() && iConcepts.empty();
+    }
+
+    const compiler_profile::rules_t& compiler_profile::rules() const
+    {
+        return iRules;
+    }
+
+    const compiler_profile::concepts_t& compiler_profile::concepts() const
+    {
+        return iConcepts;
+    }
+
+    void compiler_profile::clear()
+    {
+        iRules.clear();
+        iConcepts.clear();
+        iFrames.clear();
+        iActive.clear();
+    }
+
+    void compiler_profile::enter(const i_schema_node_atom& aRule)
+    {
+        ++iActive[&aRule];
+        iFrames.push_back(frame{ &aRule, std::chrono::steady_clock::now(), std::chrono::nanoseconds{} });
+    }
+
+    void compiler_profile::leave(parser aParser, compiler_pass aPass, bool aMatched, std::size_t aConsumed)
+    {
+        auto const finished = iFrames.back();
+        iFrames.pop_back();
+        auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - finished.start);
+        if (!iFrames.empty())
+            iFrames.back().children += elapsed;
+        auto& counters = entry(*finished.rule);
+        ++(aParser == parser::Parse ? counters.parseCalls : counters.parseTokensCalls);
+        ++(aPass == compiler_pass::Probe ? counters.probeCalls : counters.emitCalls);
+        if (aMatched)
+            counters.bytesConsumed += aConsumed;
+        else
+            ++counters.noMatches;
+        counters.exclusiveTime += elapsed - finished.children;
+        if (--iActive[finished.rule] == 0u)
+            counters.inclusiveTime += elapsed;
+    }
+
+    void compiler_profile::instantiated(const i_concept& aConcept)
+    {
+        ++entry(aConcept).instantiations;
+    }
+
+    void compiler_profile::folded(const i_concept& aConcept)
+    {
+        ++entry(aConcept).folds;
+    }
+
+    void compiler_profile::write_table(std::ostream& aOutput) const
+    {
+        auto const oldFlags = aOutput.flags();
+        auto const oldPrecision = aOutput.precision();
+        auto const rules = sorted_rules();
+        std::size_t nameWidth = 4u;
+        for (auto r : rules)
+            nameWidth = std::max(nameWidth, r->name.size());
+        aOutput << std::left << std::setw(nameWidth) << "Rule" << std::right <<
+            std::setw(10) << "parse" << std::setw(10) << "tokens" << std::setw(10) << "probe" << std::setw(10) << "emit" << 
+            std::setw(10) << "nomatch" << std::setw(12) << "bytes" << std::setw(12) << "incl(ms)" << std::setw(12) << "excl(ms)" << "\n";
+        aOutput << std::fixed << std::setprecision(3);
+        for (auto r : rules)
+            aOutput << std::left << std::setw(nameWidth) << r->name << std::right <<
+                std::setw(10) << r->parseCalls << std::setw(10) << r->parseTokensCalls << std::setw(10) << r->probeCalls << std::setw(10) << r->emitCalls <<
+                std::setw(10) << r->noMatches << std::setw(12) << r->bytesConsumed << 
+                std::setw(12) << milliseconds(r->inclusiveTime) << std::setw(12) << milliseconds(r->exclusiveTime) << "\n";
+        auto const concepts = sorted_concepts();
+        nameWidth = 7u;
+        for (auto c : concepts)
+            nameWidth = std::max(nameWidth, c->name.size());
+        aOutput << "\n" << std::left << std::setw(nameWidth) << "Concept" << std::right << std::setw(16) << "instantiations" << std::setw(10) << "folds" << "\n";
+        for (auto c : concepts)
+            aOutput << std::left << std::setw(nameWidth) << c->name << std::right << std::setw(16) << c->instantiations << std::setw(10) << c->folds << "\n";
+        aOutput.flags(oldFlags);
+        aOutput.precision(oldPrecision);
+        aOutput << std::flush;
+    }
+
+    void compiler_profile::write_json(std::ostream& aOutput) const
+    {
+        aOutput << "{\n  \"rules\": [";
+        bool first = true;
+        for (auto r : sorted_rules())
+        {
+            aOutput << (first ? "\n" : ",\n") << "    { \"rule\": \"" << json_escaped(r->name) << "\"" <<
+                ", \"parse\": " << r->parseCalls << ", \"parseTokens\": " << r->parseTokensCalls <<
+                ", \"probe\": " << r->probeCalls << ", \"emit\": " << r->emitCalls << ", \"noMatch\": " << r->noMatches <<
+                ", \"bytesConsumed\": " << r->bytesConsumed << 
+                ", \"inclusiveNs\": " << r->inclusiveTime.count() << ", \"exclusiveNs\": " << r->exclusiveTime.count() << " }";
+            first = false;
+        }
+        aOutput << (first ? "]" : "\n  ]") << ",\n  \"concepts\": [";
+        first = true;
+        for (auto c : sorted_concepts())
+        {
+            aOutput << (first ? "\n" : ",\n") << "    { \"concept\": \"" << json_escaped(c->name) << "\"" <<
+                ", \"instantiations\": " << c->instantiations << ", \"folds\": " << c->folds << " }";
+            first = false;
+        }
+        aOutput << (first ? "]" : "\n  ]") << "\n}" << std::endl;
+    }
+
+    compiler_profile::rule& compiler_profile::entry(const i_schema_node_atom& aRule)
+    {
+        auto existing = iRules.find(&aRule);
+        if (existing == iRules.end())
+            existing = iRules.emplace(&aRule, rule{ aRule.qualified_name(), 0u, 0u, 0u, 0u, 0u, 0u, {}, {} }).first;
+        return existing->second;
+    }
+
+    compiler_profile::concept_counters& compiler_profile::entry(const i_concept& aConcept)
+    {
+        auto existing = iConcepts.find(&aConcept);
+        if (existing == iConcepts.end())
+            existing = iConcepts.emplace(&aConcept, concept_counters{ aConcept.name().to_std_string(), 0u, 0u }).first;
+        return existing->second;
+    }
+
+    std::vector<const compiler_profile::rule*> compiler_profile::sorted_rules() const
+    {
+        std::vector<const rule*> result;
+        for (auto const& r : iRules)
+            result.push_back(&r.second);
+        std::sort(result.begin(), result.end(), [](const rule* lhs, const rule* rhs)
+        {
+            if (lhs->inclusiveTime != rhs->inclusiveTime)
+                return lhs->inclusiveTime > rhs->inclusiveTime;
+            return lhs->name < rhs->name;
+        });
+        return result;
+    }
+
+    std::vector<const compiler_profile::concept_counters*> compiler_profile::sorted_concepts() const
+    {
+        std::vector<const concept_counters*> result;
+        for (auto const& c : iConcepts)
+            result.push_back(&c.second);
+        std::sort(result.begin(), result.end(), [](const concept_counters* lhs, const concept_counters* rhs)
+        {
+            if (lhs->instantiations + lhs->folds != rhs->instantiations + rhs->folds)
+                return lhs->instantiations + lhs->folds > rhs->instantiations + rhs->folds;
+            return lhs->name < rhs->name;
+        });
+        return result;
+    }
+}
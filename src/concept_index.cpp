@@ -0,0 +1,130 @@
+/*
+  concept_index.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <functional>
+#include <neos/language/concept_index.hpp>
+
+namespace neos::language
+{
+    concept_index::concept_index() :
+        iMask{ 0u }
+    {
+    }
+
+    void concept_index::build(const concept_libraries_t& aConceptLibraries)
+    {
+        iNames.clear();
+        iSlots.clear();
+        iMask = 0u;
+        iCollisions.clear();
+        std::size_t concepts = 0u;
+        for (auto const& library : aConceptLibraries)
+            concepts += library.second()->concepts().size();
+        reserve(concepts);
+        for (auto const& library : aConceptLibraries)
+            add(*library.second());
+    }
+
+    void concept_index::add(const i_concept_library& aLibrary)
+    {
+        reserve(iNames.size() + aLibrary.concepts().size());
+        for (auto const& concept_ : aLibrary.concepts())
+        {
+            auto const name = concept_.first().to_std_string();
+            auto const hash = std::hash<std::string_view>{}(name);
+            auto& s = find_slot(hash, name);
+            if (s.name == NoName)
+            {
+                s.hash = hash;
+                s.name = static_cast<uint32_t>(iNames.size());
+                s.library = &aLibrary;
+                s.concept_ = concept_.second();
+                s.ambiguous = false;
+                iNames.push_back(name);
+            }
+            else if (&*s.concept_ != &*concept_.second())
+            {
+                s.ambiguous = true;
+                iCollisions.push_back(collision{ name, s.library->name().to_std_string(), aLibrary.name().to_std_string() });
+            }
+        }
+    }
+
+    neolib::ref_ptr<i_concept> concept_index::find(std::string_view aName) const
+    {
+        auto const s = find_slot(aName);
+        if (s == nullptr || s->ambiguous)
+            return nullptr;
+        return s->concept_;
+    }
+
+    bool concept_index::ambiguous(std::string_view aName) const
+    {
+        auto const s = find_slot(aName);
+        return s != nullptr && s->ambiguous;
+    }
+
+    std::size_t concept_index::size() const
+    {
+        return iNames.size();
+    }
+
+    const concept_index::collision_list& concept_index::collisions() const
+    {
+        return iCollisions;
+    }
+
+    void concept_index::reserve(std::size_t aConcepts)
+    {
+        // keep the load factor at or below one half
+        if (!iSlots.empty() && aConcepts * 2u <= iSlots.size())
+            return;
+        std::size_t capacity = std::max<std::size_t>(iSlots.size(), 16u);
+        while (capacity < aConcepts * 2u)
+            capacity *= 2u;
+        std::vector<slot> oldSlots(capacity, slot{ 0u, NoName, nullptr, {}, false });
+        oldSlots.swap(iSlots);
+        iMask = capacity - 1u;
+        for (auto& old : oldSlots)
+            if (old.name != NoName)
+                find_slot(old.hash, iNames[old.name]) = std::move(old);
+    }
+
+    concept_index::slot& concept_index::find_slot(std::size_t aHash, std::string_view aName)
+    {
+        auto index = aHash & iMask;
+        for (; iSlots[index].name != NoName; index = (index + 1u) & iMask)
+            if (iSlots[index].hash == aHash && iNames[iSlots[index].name] == aName)
+                break;
+        return iSlots[index];
+    }
+
+    const concept_index::slot* concept_index::find_slot(std::string_view aName) const
+    {
+        if (iSlots.empty())
+            return nullptr;
+        auto const hash = std::hash<std::string_view>{}(aName);
+        for (auto index = hash & iMask; iSlots[index].name != NoName; index = (index + 1u) & iMask)
+            if (iSlots[index].hash == hash && iNames[iSlots[index].name] == aName)
+                return &iSlots[index];
+        return nullptr;
+    }
+}
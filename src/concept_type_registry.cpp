@@ -0,0 +1,172 @@
+/*
+  concept_type_registry.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+#include <neos/language/concept_type_registry.hpp>
+
+namespace neos::language
+{
+    namespace
+    {
+        // '.' sorts before every other character so a name is immediately followed by the names within its namespace
+        bool namespace_order(const std::string& aLhs, const std::string& aRhs)
+        {
+            return std::lexicographical_compare(aLhs.begin(), aLhs.end(), aRhs.begin(), aRhs.end(), [](char aLeft, char aRight)
+            {
+                auto const key = [](char aCharacter) { return aCharacter == '.' ? 0u : static_cast<uint32_t>(static_cast<unsigned char>(aCharacter)) + 1u; };
+                return key(aLeft) < key(aRight);
+            });
+        }
+
+        bool within_namespace(const std::string& aName, const std::string& aNamespace)
+        {
+            return aName.size() > aNamespace.size() && aName[aNamespace.size()] == '.' && aName.compare(0u, aNamespace.size(), aNamespace) == 0;
+        }
+    }
+
+    concept_type_registry::concept_type_registry() :
+        iNextType{ 0u }, iNextPosition{ 0u }
+    {
+    }
+
+    void concept_type_registry::register_types(const concept_libraries_t& aNewConceptLibraries)
+    {
+        {
+            std::unique_lock<std::shared_mutex> lock{ iMutex };
+            std::vector<std::string> names;
+            for (auto const& library : aNewConceptLibraries)
+                for (auto const& concept_ : library.second()->concepts())
+                {
+                    auto name = concept_.second()->name().to_std_string();
+                    if (iTypes.find(name) != iTypes.end())
+                        continue;
+                    iOwners.emplace(name, &*concept_.second());
+                    names.push_back(std::move(name));
+                }
+            std::sort(names.begin(), names.end(), namespace_order);
+            names.erase(std::unique(names.begin(), names.end()), names.end());
+            auto const base = iNextType;
+            std::vector<concept_type_id> open;
+            for (concept_type_id index = 0u; index < names.size(); ++index)
+            {
+                for (; !open.empty() && !within_namespace(names[index], names[open.back() - base]); open.pop_back())
+                    iTypes[names[open.back() - base]].end = base + index;
+                iTypes[names[index]].id = base + index;
+                open.push_back(base + index);
+            }
+            iNextType = base + static_cast<concept_type_id>(names.size());
+            for (auto id : open)
+                iTypes[names[id - base]].end = iNextType;
+            freeze_hierarchy(aNewConceptLibraries, names);
+        }
+        for (auto const& library : aNewConceptLibraries)
+            for (auto const& concept_ : library.second()->concepts())
+                concept_.second()->register_type(*this);
+    }
+
+    void concept_type_registry::freeze_hierarchy(const concept_libraries_t& aNewConceptLibraries, const std::vector<std::string>& aNames)
+    {
+        // a concept's lineage is frozen only if it and all of its ancestors are new and own their names so that 
+        // an interval test never relates a concept to a different concept that merely shares a name with one of 
+        // its ancestors nor misses an ancestor whose interval was frozen by an earlier batch
+        std::unordered_set<std::string> const isNew{ aNames.begin(), aNames.end() };
+        std::unordered_map<const i_concept*, bool> freezable;
+        auto const can_freeze = [&](auto& self, const i_concept& aConcept) -> bool
+        {
+            auto existing = freezable.find(&aConcept);
+            if (existing != freezable.end())
+                return existing->second;
+            auto const name = aConcept.name().to_std_string();
+            auto owner = iOwners.find(name);
+            bool const result = isNew.find(name) != isNew.end() && owner != iOwners.end() && owner->second == &aConcept && 
+                (!aConcept.has_parent() || self(self, aConcept.parent()));
+            freezable.emplace(&aConcept, result);
+            return result;
+        };
+        std::unordered_map<std::string, std::string> parents;
+        for (auto const& library : aNewConceptLibraries)
+            for (auto const& concept_ : library.second()->concepts())
+                if (can_freeze(can_freeze, *concept_.second()) && concept_.second()->has_parent())
+                    parents.emplace(concept_.second()->name().to_std_string(), concept_.second()->parent().name().to_std_string());
+        for (auto const& name : aNames)
+        {
+            auto owner = iOwners.find(name);
+            if (owner != iOwners.end() && !can_freeze(can_freeze, *owner->second))
+                iOwners.erase(owner);
+        }
+        std::unordered_map<std::string, std::vector<std::string>> children;
+        std::vector<std::string> roots;
+        for (auto const& name : aNames)
+        {
+            if (iOwners.find(name) == iOwners.end())
+                continue;
+            auto parent = parents.find(name);
+            if (parent != parents.end())
+                children[parent->second].push_back(name);
+            else
+                roots.push_back(name);
+        }
+        auto tour = [&](auto& self, const std::string& aName) -> void
+        {
+            auto& lineage = iTypes[aName].lineage;
+            lineage.first = iNextPosition++;
+            auto existing = children.find(aName);
+            if (existing != children.end())
+                for (auto const& child : existing->second)
+                    self(self, child);
+            lineage.last = iNextPosition;
+        };
+        for (auto const& root : roots)
+            tour(tour, root);
+    }
+
+    concept_type concept_type_registry::type(const neolib::i_string& aName) const
+    {
+        return type(aName.to_std_string());
+    }
+
+    concept_type concept_type_registry::type(const i_concept& aConcept) const
+    {
+        auto const name = aConcept.name().to_std_string();
+        auto result = type(name);
+        std::shared_lock<std::shared_mutex> lock{ iMutex };
+        auto owner = iOwners.find(name);
+        if (owner == iOwners.end() || owner->second != &aConcept)
+            result.lineage = hierarchy_interval{};
+        return result;
+    }
+
+    concept_type concept_type_registry::type(const std::string& aName) const
+    {
+        std::shared_lock<std::shared_mutex> lock{ iMutex };
+        auto existing = iTypes.find(aName);
+        if (existing != iTypes.end())
+            return existing->second;
+        return concept_type{};
+    }
+
+    std::size_t concept_type_registry::types() const
+    {
+        std::shared_lock<std::shared_mutex> lock{ iMutex };
+        return iTypes.size();
+    }
+}
@@ -0,0 +1,339 @@
+/*
+  grammar_analysis.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <neos/language/i_schema_terminal_atom.hpp>
+#include <neos/language/grammar_analysis.hpp>
+
+namespace neos::language
+{
+    namespace
+    {
+        const i_schema_node_atom* as_node(const i_atom* aAtom)
+        {
+            if (aAtom != nullptr && aAtom->is_schema_atom() && aAtom->as_schema_atom().is_schema_node_atom())
+                return &aAtom->as_schema_atom().as_schema_node_atom();
+            return nullptr;
+        }
+
+        bool is_terminal(const i_atom* aAtom, schema_terminal aType)
+        {
+            return aAtom != nullptr && aAtom->is_schema_atom() && aAtom->as_schema_atom().is_schema_terminal_atom() && 
+                aAtom->as_schema_atom().as_schema_terminal_atom().type() == aType;
+        }
+
+        bool is_loop(const i_atom* aAtom)
+        {
+            return is_terminal(aAtom, schema_terminal::Continue) || is_terminal(aAtom, schema_terminal::Ignore);
+        }
+
+        template <typename Entry>
+        const i_atom* key(const Entry& aEntry)
+        {
+            return aEntry.first() ? &*aEntry.first() : nullptr;
+        }
+
+        template <typename Entry>
+        const i_atom* value(const Entry& aEntry)
+        {
+            return aEntry.second() ? &*aEntry.second() : nullptr;
+        }
+
+        std::string name_of(const i_atom& aAtom)
+        {
+            if (aAtom.is_schema_atom() && aAtom.as_schema_atom().is_schema_terminal_atom())
+            {
+                switch (aAtom.as_schema_atom().as_schema_terminal_atom().type())
+                {
+                case schema_terminal::String:
+                    return "\"" + aAtom.symbol().to_std_string() + "\"";
+                case schema_terminal::Done:
+                    return "done";
+                case schema_terminal::Drain:
+                    return "drain";
+                case schema_terminal::Next:
+                    return "next";
+                case schema_terminal::Continue:
+                    return "continue";
+                case schema_terminal::Ignore:
+                    return "ignore";
+                case schema_terminal::Error:
+                    return "error";
+                case schema_terminal::Default:
+                    return "default";
+                }
+            }
+            if (as_node(&aAtom) == nullptr)
+                return aAtom.symbol().to_std_string();
+            return aAtom.qualified_name();
+        }
+
+        std::string quoted(const i_atom& aAtom)
+        {
+            if (aAtom.is_schema_atom() && aAtom.as_schema_atom().is_schema_terminal_atom())
+                return name_of(aAtom);
+            return "'" + name_of(aAtom) + "'";
+        }
+
+        std::string describe(const character_set& aCharacters)
+        {
+            if (aCharacters.full())
+                return "any character";
+            auto character = [](uint32_t aCharacter)
+            {
+                std::ostringstream result;
+                if (aCharacter > 0x20u && aCharacter < 0x7Fu && aCharacter != '\'')
+                    result << '\'' << static_cast<char>(aCharacter) << '\'';
+                else
+                    result << "\\x" << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << aCharacter;
+                return result.str();
+            };
+            std::string result;
+            std::size_t ranges = 0u;
+            for (uint32_t ch = 0u; ch < 256u; ++ch)
+            {
+                if (!aCharacters.test(static_cast<char>(ch)))
+                    continue;
+                auto last = ch;
+                while (last < 255u && aCharacters.test(static_cast<char>(last + 1u)))
+                    ++last;
+                if (++ranges > 8u)
+                    return result + ", ...";
+                result += (result.empty() ? std::string{} : ", ") + character(ch) + (last != ch ? "-" + character(last) : std::string{});
+                ch = last;
+            }
+            return result;
+        }
+    }
+
+    grammar_analysis::grammar_analysis(const std::vector<i_schema_node_atom*>& aNodes, const locator_t& aLocator) :
+        iLocator{ aLocator }
+    {
+        find_left_recursion(aNodes);
+        find_unbounded_loops(aNodes);
+        find_shadowing_defaults(aNodes);
+        find_overlapping_alternatives(aNodes);
+        std::stable_sort(iWarnings.begin(), iWarnings.end(), [](const warning& aLhs, const warning& aRhs)
+        {
+            if (aLhs.kind != aRhs.kind)
+                return aLhs.kind < aRhs.kind;
+            return aLhs.weight > aRhs.weight;
+        });
+    }
+
+    grammar_analysis::grammar_analysis(const warnings_t& aWarnings) :
+        iWarnings{ aWarnings }
+    {
+    }
+
+    const grammar_analysis::warnings_t& grammar_analysis::warnings() const
+    {
+        return iWarnings;
+    }
+
+    void grammar_analysis::find_left_recursion(const std::vector<i_schema_node_atom*>& aNodes)
+    {
+        // the nodes a node can parse at the position it was entered at: every alternative's key (an alternative that 
+        // fails hands the same position to the next), a default's value and an expected node that names a concept
+        auto leading = [](const i_schema_node_atom& aNode)
+        {
+            std::vector<const i_schema_node_atom*> result;
+            for (auto const& token : aNode.tokens())
+            {
+                if (auto const keyNode = as_node(key(token)))
+                    result.push_back(keyNode);
+                else if (is_terminal(key(token), schema_terminal::Default) && as_node(value(token)) != nullptr)
+                    result.push_back(as_node(value(token)));
+            }
+            for (auto const& expect : aNode.expects())
+                if (auto const expectNode = as_node(expect ? &*expect : nullptr))
+                    if (expectNode->as())
+                        result.push_back(expectNode);
+            return result;
+        };
+        // Tarjan's strongly connected components; a component that can reach itself is left recursive
+        struct state
+        {
+            std::size_t index;
+            std::size_t lowLink;
+            bool onStack;
+        };
+        std::unordered_map<const i_schema_node_atom*, state> states;
+        std::vector<const i_schema_node_atom*> stack;
+        std::vector<std::vector<const i_schema_node_atom*>> components;
+        auto connect = [&](auto& self, const i_schema_node_atom& aNode) -> void
+        {
+            auto const index = states.size();
+            states[&aNode] = state{ index, index, true };
+            stack.push_back(&aNode);
+            for (auto next : leading(aNode))
+            {
+                auto existing = states.find(next);
+                if (existing == states.end())
+                {
+                    self(self, *next);
+                    states[&aNode].lowLink = std::min(states[&aNode].lowLink, states[next].lowLink);
+                }
+                else if (existing->second.onStack)
+                    states[&aNode].lowLink = std::min(states[&aNode].lowLink, existing->second.index);
+            }
+            if (states[&aNode].lowLink != states[&aNode].index)
+                return;
+            std::vector<const i_schema_node_atom*> component;
+            const i_schema_node_atom* member;
+            do
+            {
+                member = stack.back();
+                stack.pop_back();
+                states[member].onStack = false;
+                component.push_back(member);
+            } while (member != &aNode);
+            components.push_back(std::move(component));
+        };
+        for (auto node : aNodes)
+            if (states.find(node) == states.end())
+                connect(connect, *node);
+        for (auto const& component : components)
+        {
+            std::unordered_set<const i_schema_node_atom*> const members{ component.begin(), component.end() };
+            auto const start = component.back();
+            // shortest path from the component's first node back to itself
+            std::unordered_map<const i_schema_node_atom*, const i_schema_node_atom*> via;
+            std::deque<const i_schema_node_atom*> pending{ start };
+            bool cycle = false;
+            while (!pending.empty() && !cycle)
+            {
+                auto const current = pending.front();
+                pending.pop_front();
+                for (auto next : leading(*current))
+                {
+                    if (members.find(next) == members.end())
+                        continue;
+                    if (next == start)
+                    {
+                        via[nullptr] = current;
+                        cycle = true;
+                        break;
+                    }
+                    if (via.emplace(next, current).second)
+                        pending.push_back(next);
+                }
+            }
+            if (!cycle)
+                continue;
+            std::vector<const i_schema_node_atom*> path{ start };
+            for (auto node = via[nullptr]; node != start; node = via[node])
+                path.insert(std::next(path.begin()), node);
+            path.push_back(start);
+            std::string route;
+            for (auto node : path)
+                route += (route.empty() ? std::string{} : " -> ") + quoted(*node);
+            add(finding::LeftRecursion, component.size(), static_cast<const i_atom*>(start),
+                "left recursion " + route + ": " + quoted(*start) + " can be re-entered without consuming input, retrying its alternatives at every level up to the recursion limit");
+        }
+    }
+
+    void grammar_analysis::find_unbounded_loops(const std::vector<i_schema_node_atom*>& aNodes)
+    {
+        for (auto node : aNodes)
+        {
+            if (node->tokens().empty())
+                continue;
+            std::size_t loops = 0u;
+            bool exits = false;
+            for (auto const& token : node->tokens())
+                if (is_loop(value(token)))
+                    ++loops;
+                else
+                    exits = true;
+            if (loops == 0u || exits)
+                continue;
+            add(finding::UnboundedLoop, loops, static_cast<const i_atom*>(node),
+                "every alternative of " + quoted(*node) + " continues or ignores: it only stops at the end of the input or when no alternative matches, which discards everything it consumed");
+        }
+    }
+
+    void grammar_analysis::find_shadowing_defaults(const std::vector<i_schema_node_atom*>& aNodes)
+    {
+        // a node whose default continues or ignores accepts any character so once tried it does not fail
+        auto accepts_anything = [](const i_schema_node_atom& aNode)
+        {
+            for (auto const& token : aNode.tokens())
+                if (is_terminal(key(token), schema_terminal::Default) && is_loop(value(token)))
+                    return true;
+            return false;
+        };
+        for (auto node : aNodes)
+        {
+            for (auto token = node->tokens().begin(); token != node->tokens().end(); ++token)
+            {
+                auto const keyNode = as_node(key(*token));
+                if (keyNode == nullptr || !accepts_anything(*keyNode))
+                    continue;
+                std::size_t shadowed = 0u;
+                std::string names;
+                for (auto later = std::next(token); later != node->tokens().end(); ++later)
+                    if (key(*later) != nullptr && !is_terminal(key(*later), schema_terminal::Default))
+                    {
+                        ++shadowed;
+                        names += (names.empty() ? std::string{} : ", ") + quoted(*key(*later));
+                    }
+                if (shadowed == 0u)
+                    continue;
+                add(finding::ShadowingDefault, shadowed, &*token,
+                    "the default of " + quoted(*keyNode) + " accepts any character so the alternatives after it in " + quoted(*node) + " (" + names + ") are never reached once it is tried");
+            }
+        }
+    }
+
+    void grammar_analysis::find_overlapping_alternatives(const std::vector<i_schema_node_atom*>& aNodes)
+    {
+        for (auto node : aNodes)
+        {
+            for (auto later = node->tokens().begin(); later != node->tokens().end(); ++later)
+            {
+                if (key(*later) == nullptr || is_terminal(key(*later), schema_terminal::Default))
+                    continue;
+                for (auto earlier = node->tokens().begin(); earlier != later; ++earlier)
+                {
+                    if (key(*earlier) == nullptr || is_terminal(key(*earlier), schema_terminal::Default))
+                        continue;
+                    auto overlap = key(*earlier)->first_characters();
+                    overlap &= key(*later)->first_characters();
+                    if (overlap.empty())
+                        continue;
+                    add(finding::OverlappingAlternatives, overlap.count(), &*later,
+                        "alternatives " + quoted(*key(*earlier)) + " and " + quoted(*key(*later)) + " of " + quoted(*node) + " can both start with " + describe(overlap) + 
+                        ": " + quoted(*key(*later)) + " is only tried after " + quoted(*key(*earlier)) + " has been parsed and abandoned");
+                }
+            }
+        }
+    }
+
+    void grammar_analysis::add(finding aKind, std::size_t aWeight, const void* aDefinition, const std::string& aText)
+    {
+        iWarnings.push_back(warning{ aKind, aWeight, iLocator ? iLocator(aDefinition, aText) : aText });
+    }
+}
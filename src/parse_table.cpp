@@ -0,0 +1,133 @@
+/*
+  parse_table.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <neos/language/i_concept_atom.hpp>
+#include <neos/language/i_schema_terminal_atom.hpp>
+#include <neos/language/parse_table.hpp>
+
+namespace neos::language
+{
+    parse_table::parse_table(const std::vector<i_schema_node_atom*>& aNodes)
+    {
+        std::size_t alternativeCount = 0u;
+        for (auto const& n : aNodes)
+            alternativeCount += n->tokens().size();
+        iAlternatives.reserve(alternativeCount);
+        iNodes.reserve(aNodes.size());
+        for (auto const& n : aNodes)
+        {
+            auto const start = iAlternatives.size();
+            for (auto const& token : n->tokens())
+                if (token.first())
+                    iAlternatives.push_back(alternative{ &*token.first(), token.second() ? &*token.second() : nullptr, token.first()->first_characters() });
+            auto const count = iAlternatives.size() - start;
+            if (count == 0u || count >= Ambiguous || count != n->tokens().size())
+                continue;
+            iIndex.emplace(n, iNodes.size());
+            iNodes.push_back(node{ n, start, static_cast<alternative_index>(count), !n->is_token_node() });
+        }
+        for (std::size_t index = 0u; index < iNodes.size(); ++index)
+        {
+            auto& entry = iNodes[index];
+            auto const start = entry.firstAlternative;
+            auto const count = entry.alternativeCount;
+            entry.prediction.fill(NoAlternative);
+            // a trailing default is only ever tried once every other alternative has failed so it takes no part in prediction
+            auto predictable = count;
+            auto const& last = *iAlternatives[start + count - 1u].key;
+            if (last.is_schema_atom() && last.as_schema_atom().is_schema_terminal_atom() && last.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::Default)
+                --predictable;
+            for (std::size_t i = 0u; i < predictable; ++i)
+            {
+                auto const& first = iAlternatives[start + i].first;
+                for (uint32_t ch = 0u; ch < 256u; ++ch)
+                    if (first.test(static_cast<char>(ch)))
+                    {
+                        auto& predicted = entry.prediction[ch];
+                        if (predicted == NoAlternative)
+                            predicted = static_cast<alternative_index>(i);
+                        else
+                        {
+                            predicted = Ambiguous;
+                            entry.deterministic = false;
+                        }
+                    }
+            }
+            compute_runs(entry);
+        }
+    }
+
+    void parse_table::compute_runs(node& aNode) const
+    {
+        aNode.candidate.fill(NoAlternative);
+        for (alternative_index i = 0u; i < aNode.alternativeCount; ++i)
+        {
+            auto const& first = iAlternatives[aNode.firstAlternative + i].first;
+            for (uint32_t ch = 0u; ch < 256u; ++ch)
+                if (aNode.candidate[ch] == NoAlternative && first.test(static_cast<char>(ch)))
+                    aNode.candidate[ch] = i;
+        }
+        if (aNode.atom->is_token_node() || !aNode.atom->is().empty())
+            return;
+        character_set run;
+        for (uint32_t ch = 0u; ch < 256u; ++ch)
+        {
+            if (aNode.candidate[ch] == NoAlternative)
+                continue;
+            auto const& alternative = iAlternatives[aNode.firstAlternative + aNode.candidate[ch]];
+            if (!alternative.key->is_concept_atom() || !alternative.key->as_concept_atom().get_concept().is_character_class())
+                continue;
+            if (alternative.value == nullptr || !alternative.value->is_schema_atom() || !alternative.value->as_schema_atom().is_schema_terminal_atom() ||
+                alternative.value->as_schema_atom().as_schema_terminal_atom().type() != schema_terminal::Continue)
+                continue;
+            run.set(static_cast<char>(ch));
+        }
+        aNode.run = character_scanner{ run };
+    }
+
+    const parse_table::node* parse_table::find(const i_schema_node_atom& aAtom) const
+    {
+        auto existing = iIndex.find(&aAtom);
+        if (existing != iIndex.end())
+            return &iNodes[existing->second];
+        return nullptr;
+    }
+
+    const i_atom& parse_table::predict(const node& aNode, char aCharacter) const
+    {
+        auto const predicted = aNode.prediction[static_cast<unsigned char>(aCharacter)];
+        return *iAlternatives[aNode.firstAlternative + (predicted != NoAlternative ? predicted : aNode.alternativeCount - 1u)].key;
+    }
+
+    const i_atom& parse_table::candidate(const node& aNode, char aCharacter) const
+    {
+        return *iAlternatives[aNode.firstAlternative + aNode.candidate[static_cast<unsigned char>(aCharacter)]].key;
+    }
+
+    const parse_table::nodes_t& parse_table::nodes() const
+    {
+        return iNodes;
+    }
+
+    std::size_t parse_table::deterministic_nodes() const
+    {
+        return std::count_if(iNodes.begin(), iNodes.end(), [](const node& aNode) { return aNode.deterministic; });
+    }
+}
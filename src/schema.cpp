@@ -1,486 +1,910 @@
-/*
-  schema.cpp
-
-  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
-
-  This program is free software: you can redistribute it and / or modify
-  it under the terms of the GNU General Public License as published by
-  the Free Software Foundation, either version 3 of the License, or
-  (at your option) any later version.
-
-  This program is distributed in the hope that it will be useful,
-  but WITHOUT ANY WARRANTY; without even the implied warranty of
-  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-  GNU General Public License for more details.
-
-  You should have received a copy of the GNU General Public License
-  along with this program.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#include <neos/neos.hpp>
-#include <neolib/core/scoped.hpp>
-#include <neolib/core/recursion.hpp>
-#include <neos/language/schema.hpp>
-
-namespace neos
-{
-    namespace language
-    {
-        schema::schema(neolib::rjson const& aSource, const concept_libraries_t& aConceptLibraries) :
-            iSource{ aSource },
-            iMeta{ aSource.root().as<neolib::rjson_object>().at("meta").as<neolib::rjson_object>().at("language").as<neolib::rjson_string>() },
-            iConceptLibraries{ aConceptLibraries },
-            iRoot{ neolib::make_ref<schema_node_atom>() },
-            iParsingTokens{ false }
-        {
-            parse(aSource.root(), iRoot->as_schema_atom().as_schema_node_atom());
-            resolve_references();
-            if (!atom_references().empty())
-            {
-                unresolved_reference_list references;
-                for (auto const& r : atom_references())
-                    for (auto const& e : r.second)
-                        references.push_back(e);
-                throw unresolved_references(std::move(references));
-            }
-        }
-
-        i_schema_node_atom& schema::root() const
-        {
-            return iRoot->as_schema_atom().as_schema_node_atom();
-        }
-
-        meta const& schema::meta() const
-        {
-            return iMeta;
-        }
-
-        schema_keyword schema::keyword(const neolib::rjson_string& aSymbol)
-        {
-            static std::map<std::string, schema_keyword> sKeywords = 
-            {
-                { "meta", schema_keyword::Meta},
-                { "libraries", schema_keyword::Libraries},
-                { "is", schema_keyword::Is},
-                { "as", schema_keyword::As},
-                { "done", schema_keyword::Done},
-                { "drain", schema_keyword::Drain},
-                { "next", schema_keyword::Next},
-                { "continue", schema_keyword::Continue},
-                { "ignore", schema_keyword::Ignore},
-                { "none", schema_keyword::None},
-                { "error", schema_keyword::Error},
-                { "default", schema_keyword::Default},
-                { "expect", schema_keyword::Expect},
-                { "tokens", schema_keyword::Tokens},
-            };
-            auto result = sKeywords.find(aSymbol);
-            if (result != sKeywords.end())
-                return result->second;
-            return schema_keyword::Invalid;
-        }
-
-        void schema::default_atom_handler(neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-        {
-            if (aChildNode.name_is_keyword())
-            {
-                if (keyword(aChildNode.name()) != schema_keyword::Invalid)
-                    throw_error(aChildNode, "unexpected keyword '" + aChildNode.name() + "'");
-                else if (aChildNode.type() != neolib::json_type::Object && !iParsingTokens)
-                    throw_error(aChildNode, "unexpected token match rule");
-            }
-            else if (!iParsingTokens)
-                throw_error(aChildNode, "unexpected token match rule");
-            auto newChild = aParentAtom.children().insert(
-                atom_ptr{ neolib::make_ref<schema_node_atom>(aParentAtom, aChildNode.name()) }, atom_ptr{});
-            parse(aChildNode, newChild->first()->as_schema_atom().as_schema_node_atom());
-        }
-
-        schema::atom_handlers_t& schema::atom_handlers()
-        {
-            if (iAtomHandlers == std::nullopt)
-            {
-                iAtomHandlers = atom_handlers_t
-                {
-                    { schema_keyword::Meta, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        if (aChildNode.parent().is_root())
-                            parse_meta(aChildNode);
-                        else
-                            default_atom_handler(aChildNode, aParentAtom);
-                    } },
-                    { schema_keyword::Meta, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        if (aChildNode.parent().is_root())
-                            parse_meta(aChildNode);
-                        else
-                            default_atom_handler(aChildNode, aParentAtom);
-                    } },
-                    { schema_keyword::Libraries, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        if (aChildNode.parent().is_root())
-                            parse_meta(aChildNode);
-                        else
-                            default_atom_handler(aChildNode, aParentAtom);
-                    } },
-                    { schema_keyword::Is, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        auto const& conceptName = aChildNode.as<neolib::rjson_keyword>().text;
-                        auto concept_ = find_concept(conceptName);
-                        if (concept_ != nullptr)
-                            aParentAtom.is().push_back(concept_);
-                        else
-                            throw_error(aChildNode, "concept '" + conceptName + "' not found");
-                    } },
-                    { schema_keyword::As, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        auto const& conceptName = aChildNode.as<neolib::rjson_keyword>().text;
-                        auto concept_ = find_concept(conceptName);
-                        if (concept_ != nullptr)
-                            aParentAtom.as() = concept_;
-                        else
-                            throw_error(aChildNode, "concept '" + conceptName + "' not found");
-                    } },
-                    { schema_keyword::Default, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        parse_tokens(aChildNode, aParentAtom);
-                    } },
-                    { schema_keyword::Expect, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        if (aChildNode.type() != neolib::json_type::Keyword ||
-                            keyword(aChildNode.as<neolib::rjson_keyword>().text) != schema_keyword::None)
-                        {
-                            aParentAtom.expects().push_back(atom_ptr{});
-                            add_rhs_atom_reference(aChildNode, aParentAtom, aParentAtom.expects().back());
-                        }
-                        else
-                            aParentAtom.set_expect_none();
-                    } },
-                    { schema_keyword::Tokens, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
-                    {
-                        parse_tokens(aChildNode, aParentAtom);
-                    } }
-                };
-            }
-            return *iAtomHandlers;
-        }
-
-        void schema::parse(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom)
-        {
-            _limit_recursion_(schema);
-            for (auto const& childNode : aNode)
-            {
-                auto method = (childNode.name_is_keyword() ? atom_handlers().find(keyword(childNode.name())) : atom_handlers().end());
-                if (method != atom_handlers().end())
-                    method->second(childNode, aAtom);
-                else
-                    default_atom_handler(childNode, aAtom);
-            }
-        }
-
-        void schema::parse_meta(neolib::rjson_value const& aNode)
-        {
-            if (keyword(aNode.name()) == schema_keyword::Meta)
-            {
-                for (auto const& meta : aNode)
-                {
-                    if (meta.name() == "description")
-                        iMeta.description = meta.as<neolib::rjson_string>();
-                    else if (meta.name() == "copyright")
-                        iMeta.copyright = meta.as<neolib::rjson_string>();
-                    else if (meta.name() == "version")
-                        iMeta.version = meta.as<neolib::rjson_string>();
-                    else if (meta.name() == "source.file.extension")
-                    {
-                        if (meta.type() == neolib::json_type::String)
-                            iMeta.sourcecodeFileExtension.push_back(meta.as<neolib::rjson_string>());
-                        else
-                            for (auto const& ext : meta)
-                                iMeta.sourcecodeFileExtension.push_back(ext.as<neolib::rjson_string>());
-                    }
-                    else if (meta.name() == "source.source.package.specification.file.extension")
-                    {
-                        if (meta.type() == neolib::json_type::String)
-                            iMeta.sourcecodeModulePackageSpecificationFileExtension.push_back(meta.as<neolib::rjson_string>());
-                        else
-                            for (auto const& ext : meta)
-                                iMeta.sourcecodeModulePackageSpecificationFileExtension.push_back(ext.as<neolib::rjson_string>());
-                    }
-                    else if (meta.name() == "source.source.package.implementation.file.extension")
-                    {
-                        if (meta.type() == neolib::json_type::String)
-                            iMeta.sourcecodeModulePackageImplementationFileExtension.push_back(meta.as<neolib::rjson_string>());
-                        else
-                            for (auto const& ext : meta)
-                                iMeta.sourcecodeModulePackageImplementationFileExtension.push_back(ext.as<neolib::rjson_string>());
-                    }
-                }
-            }
-            else if (keyword(aNode.name()) == schema_keyword::Libraries)
-            {
-                for (auto const& library : aNode)
-                    if (iConceptLibraries.find(neolib::string{ library.as<neolib::rjson_keyword>().text }) == iConceptLibraries.end())
-                        throw_error(aNode, "concept library '" + library.as<neolib::rjson_keyword>().text + "' not found");
-            }
-        }
-
-        void schema::parse_tokens(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom)
-        {
-            _limit_recursion_(schema);
-            neolib::scoped_flag sf{ iParsingTokens };
-            auto& result = aAtom.tokens();
-            auto parse_token_value = [&aAtom, &result](schema& aSchema, auto&& aToken)
-            {
-                aToken.visit([&aSchema, &aToken, &aAtom, &result](auto&& aNodeValue)
-                {
-                    typedef typename std::remove_cv<typename std::remove_reference<decltype(aNodeValue)>::type>::type type_t;
-                    if constexpr (std::is_same_v<type_t, neolib::rjson_keyword> || std::is_same_v<type_t, neolib::rjson_string>)
-                        aSchema.add_rhs_atom_reference(aToken, aAtom, result.back().second());
-                    else if constexpr (std::is_same_v<type_t, neolib::rjson_object>)
-                    {
-                        auto newNode = neolib::make_ref<schema_node_atom>(aAtom, aToken.name() + ".*");
-                        aSchema.add_lhs_atom_reference(aToken, aAtom, newNode->token_ref_ptr());
-                        result.back().second() = newNode;
-                        aSchema.parse_tokens(aToken, *newNode);
-                    }
-                }, false);
-            };
-            std::map<const char*, neolib::rjson_value::const_iterator> tokensInDocumentOrder;
-            for (auto iterToken = aNode.cbegin(); iterToken != aNode.cend(); ++iterToken)
-            {
-                auto const& token = *iterToken;
-                tokensInDocumentOrder[&token.name()[0]] = iterToken;
-            }
-            for (auto iterToken = tokensInDocumentOrder.cbegin(); iterToken != tokensInDocumentOrder.cend(); ++iterToken)
-            {
-                auto const& token = *iterToken->second;
-                switch (keyword(token.name()))
-                {
-                case schema_keyword::Expect:
-                    if (token.type() != neolib::json_type::Keyword ||
-                        keyword(token.as<neolib::rjson_keyword>().text) != schema_keyword::None)
-                    {
-                        aAtom.expects().push_back(atom_ptr{});
-                        add_rhs_atom_reference(token, aAtom, aAtom.expects().back());
-                    }
-                    else
-                        aAtom.set_expect_none();
-                    break;
-                case schema_keyword::Default:
-                    if (iterToken != std::prev(tokensInDocumentOrder.cend()))
-                        throw_error(token, "default specifier must appear last in token specification block");
-                    result.push_back(schema_node_atom::tokens_t::value_type{});
-                    result.back().first() = neolib::make_ref<schema_terminal_atom>(aAtom, schema_terminal::Default);
-                    parse_token_value(*this, token);
-                    break;
-                case schema_keyword::Invalid:
-                    result.push_back(schema_node_atom::tokens_t::value_type{});
-                    add_lhs_atom_reference(token, aAtom, result.back().first());
-                    parse_token_value(*this, token);
-                    break;
-                default:
-                    throw_error(aNode, "unexpected keyword '" + token.name() + "' in token specification");
-                    break;
-                }
-            }
-        }
-
-        std::string schema::fully_qualified_name(neolib::rjson_value const& aNode) const
-        {
-            _limit_recursion_(schema);
-            auto next_node = [&aNode]() -> neolib::rjson_value const&
-            {
-                for (auto n = &aNode; n->has_parent(); n = &n->parent())
-                    if (n->name_is_keyword() && (keyword(n->name()) == schema_keyword::Tokens || keyword(n->name()) == schema_keyword::Default))
-                        return n->parent();
-                return aNode;
-            };
-            auto const& nextNode = next_node();
-            if (nextNode.is_root())
-                return std::string{};
-            auto lhs = fully_qualified_name(nextNode.parent());
-            return lhs + (!lhs.empty() ? "." : std::string{}) + nextNode.name();
-        }
-
-        std::string schema::fully_qualified_name(neolib::rjson_value const& aNode, const neolib::rjson_string& aLeafName) const
-        {
-            auto lhs = fully_qualified_name(aNode);
-            return lhs + (!lhs.empty() ? "." : std::string{}) + aLeafName;
-        }
-
-        const schema::atom_references_t& schema::atom_references() const
-        {
-            return iAtomReferences;
-        }
-
-        schema::atom_references_t& schema::atom_references()
-        {
-            return iAtomReferences;
-        }
-
-        void schema::add_lhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom)
-        {
-            if (aNode.name_is_keyword())
-            {
-                if (keyword(aNode.name()) == schema_keyword::Invalid)
-                {
-                    auto const key = atom_reference_key_t{ aNode.name(), fully_qualified_name(aNode.parent(), aNode.name()) };
-                    atom_references()[key].push_back(atom_reference{ &aNode, &aAtom });
-                }
-                else
-                    throw_error(aNode, "unexpected keyword '" + aNode.name() + "'");
-            }
-            else
-                aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::String, aNode.name());
-        }
-
-        void schema::add_rhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom)
-        {
-            aNode.visit([this, &aNode, &aParentAtom, &aAtom](auto&& aNodeValue)
-            {
-                typedef typename std::remove_cv<typename std::remove_reference<decltype(aNodeValue)>::type>::type type_t;
-                if constexpr (std::is_same_v<type_t, neolib::rjson_keyword>)
-                {
-                    switch (keyword(aNodeValue.text))
-                    {
-                    case schema_keyword::Invalid:
-                        {
-                            auto const key = atom_reference_key_t{ aNodeValue.text, fully_qualified_name(aNode.parent(), aNodeValue.text) };
-                            atom_references()[key].push_back(atom_reference{ &aNode, &aAtom });
-                        }
-                        break;
-                    case schema_keyword::Done:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Done);
-                        break;
-                    case schema_keyword::Drain:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Drain);
-                        break;
-                    case schema_keyword::Next:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Next);
-                        break;
-                    case schema_keyword::Continue:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Continue);
-                        break;
-                    case schema_keyword::Ignore:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Ignore);
-                        break;
-                    case schema_keyword::Error:
-                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Error);
-                        break;
-                    default:
-                        throw_error(aNode, "unexpected keyword '" + aNodeValue.text + "'");
-                    }
-                }
-                else if constexpr (std::is_same_v<type_t, neolib::rjson_string>)
-                    aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::String, aNodeValue);
-            }, false);
-        }
-
-        void schema::resolve_references()
-        {
-            bool foundSome = false;
-            do
-            {
-                foundSome = false;
-                for (auto entry = atom_references().begin(); entry != atom_references().end();)
-                {
-                    auto atom = leaf(entry->first.second, entry->first.first);
-                    if (atom != nullptr)
-                    {
-                        for (auto& r : entry->second)
-                            *r.atomPtr = atom;
-                        entry = atom_references().erase(entry);
-                        foundSome = true;
-                        continue;
-                    }
-                    auto concept_ = find_concept(entry->first.first);
-                    if (concept_ != nullptr)
-                    {
-                        auto conceptAtom = create_concept_atom(concept_);
-                        for (auto& r : entry->second)
-                            *r.atomPtr = conceptAtom;
-                        entry = atom_references().erase(entry);
-                        foundSome = true;
-                        continue;
-                    }
-                    ++entry;
-                }
-            } while (foundSome);
-        }
-
-        std::string schema::fully_qualified_name(const i_atom& aAtom) const
-        {
-            if (!aAtom.has_parent())
-                return aAtom.symbol();
-            return fully_qualified_name(aAtom.parent()) + aAtom.symbol();
-        }
-        
-        schema::atom_ptr schema::leaf(const std::string& aStem, const neolib::rjson_string& aLeafName)
-        {
-            return leaf(iRoot->as_schema_atom().as_schema_node_atom(), aStem, aLeafName);
-        }
-
-        schema::atom_ptr schema::leaf(i_schema_node_atom& aNode, const std::string& aStem, const neolib::rjson_string& aLeafName)
-        {
-            _limit_recursion_(schema);
-            if (aStem == aNode.symbol())
-            {
-                if (aLeafName == aStem)
-                    return &aNode;
-            }
-            for (auto& concept_ : aNode.is())
-            {
-                if (concept_->name() == neolib::string{ aLeafName })
-                    return neolib::make_ref<concept_atom>(concept_);
-                auto const base = concept_->name() + ".";
-                auto matchingConcept = find_concept(base + aLeafName);
-                if (matchingConcept == nullptr && aLeafName.find(base.to_std_string()) == 0)
-                    matchingConcept = find_concept(aLeafName);
-                if (matchingConcept != nullptr)
-                    return create_concept_atom(matchingConcept);
-            }
-            auto delim = std::find(aStem.begin(), aStem.end(), '.');
-            schema_node_atom key{ aNode, std::string{ aStem.begin(), delim } };
-            auto child = aNode.children().find(neolib::ref_ptr<i_atom>{ key });
-            if (child != aNode.children().end())
-            {
-                if (delim != aStem.end())
-                {
-                    auto newStem = std::string{ std::next(delim), aStem.end() };
-                    return leaf(child->first()->as_schema_atom().as_schema_node_atom(), newStem, aLeafName != aStem ? aLeafName : neolib::rjson_string{ newStem });
-                }
-                else
-                    return child->first();
-            }
-            if (aNode.has_parent())
-                return leaf(aNode.parent().as_schema_atom().as_schema_node_atom(), aStem, aLeafName);
-            return atom_ptr{};
-        }
-
-        schema::atom_ptr schema::create_concept_atom(const neolib::i_ref_ptr<i_concept>& aConcept)
-        {
-            auto iterConceptAtom = iConceptAtoms.find(&*aConcept);
-            if (iterConceptAtom == iConceptAtoms.end())
-                iterConceptAtom = iConceptAtoms.emplace(&*aConcept, neolib::make_ref<concept_atom>(aConcept)).first;
-            return iterConceptAtom->second;
-        }
-
-        neolib::ref_ptr<i_concept> schema::find_concept(const std::string& aSymbol) const
-        {
-            neolib::ref_ptr<i_concept> concept_;
-            for (auto const& cl : iConceptLibraries)
-            {
-                if (cl.second()->find_concept(neolib::string{ aSymbol }, concept_))
-                    return concept_;
-            }
-            return nullptr;
-        }
-
-        void schema::throw_error(neolib::rjson_value const& aNode, const std::string aErrorText)
-        {
-            if (aNode.has_name())
-                throw std::runtime_error(iSource.to_error_text(aNode, aErrorText));
-            throw std::runtime_error(aErrorText);
-        }
-   }
+/*
+  schema.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <unordered_set>
+#include <neolib/core/scoped.hpp>
+#include <neolib/core/recursion.hpp>
+#include <neos/language/schema.hpp>
+
+namespace neos
+{
+    namespace language
+    {
+        schema::schema(neolib::rjson const& aSource, i_concept_provider& aConcepts) :
+            iSource{ &aSource },
+            iMeta{ aSource.root().as<neolib::rjson_object>().at("meta").as<neolib::rjson_object>().at("language").as<neolib::rjson_string>() },
+            iConcepts{ aConcepts },
+            iRoot{ neolib::make_ref<schema_node_atom>() },
+            iParsingTokens{ false }
+        {
+            parse(aSource.root(), iRoot->as_schema_atom().as_schema_node_atom());
+            index_nodes();
+            resolve_references();
+            if (!atom_references().empty())
+            {
+                unresolved_reference_list references;
+                for (auto const& r : atom_references())
+                    for (auto const& e : r.second)
+                        references.push_back(e);
+                throw unresolved_references(std::move(references));
+            }
+            compute_first_characters();
+            freeze_hierarchy();
+            create_parse_table();
+            analyze();
+            // the source is only needed to report errors while building; a built schema can outlive it
+            iDefinitions.clear();
+            iSource = nullptr;
+        }
+
+        schema::schema(schema_image& aImage, i_concept_provider& aConcepts) :
+            iSource{ nullptr },
+            iConcepts{ aConcepts },
+            iParsingTokens{ false }
+        {
+            read_image(aImage);
+            create_parse_table();
+        }
+
+        i_schema_node_atom& schema::root() const
+        {
+            return iRoot->as_schema_atom().as_schema_node_atom();
+        }
+
+        meta const& schema::meta() const
+        {
+            return iMeta;
+        }
+
+        parse_table const& schema::parse_table() const
+        {
+            return *iParseTable;
+        }
+
+        grammar_analysis const& schema::analysis() const
+        {
+            return *iAnalysis;
+        }
+
+        void schema::save_image(const std::string& aPath, const schema_image::version_stamp& aStamp) const
+        {
+            schema_image_writer image{ aStamp };
+            auto write_strings = [&image](const std::vector<std::string>& aStrings)
+            {
+                image.write(static_cast<uint32_t>(aStrings.size()));
+                for (auto const& s : aStrings)
+                    image.write_string(s);
+            };
+            image.write_string(iMeta.name);
+            image.write_string(iMeta.description);
+            image.write_string(iMeta.copyright);
+            image.write_string(iMeta.version);
+            write_strings(iMeta.sourcecodeFileExtension);
+            write_strings(iMeta.sourcecodeModulePackageSpecificationFileExtension);
+            write_strings(iMeta.sourcecodeModulePackageImplementationFileExtension);
+            write_strings(iMeta.libraries);
+            image.write(static_cast<uint64_t>(iMeta.parserRecursionLimit));
+            // number the atom graph so that every atom follows its parent
+            std::vector<const i_atom*> atoms;
+            std::unordered_map<const i_atom*, schema_image::atom_index> indices;
+            auto index = [&](auto& self, const i_atom* aAtom) -> schema_image::atom_index
+            {
+                if (aAtom == nullptr)
+                    return schema_image::NoAtom;
+                auto existing = indices.find(aAtom);
+                if (existing != indices.end())
+                    return existing->second;
+                if (aAtom->has_parent())
+                    self(self, &aAtom->parent());
+                auto const result = static_cast<schema_image::atom_index>(atoms.size());
+                indices.emplace(aAtom, result);
+                atoms.push_back(aAtom);
+                return result;
+            };
+            auto index_of = [&](const i_atom* aAtom)
+            {
+                return index(index, aAtom);
+            };
+            auto pointer = [](auto const& aAtomPtr) -> const i_atom*
+            {
+                return aAtomPtr ? &*aAtomPtr : nullptr;
+            };
+            auto is_node = [](const i_atom& aAtom)
+            {
+                return aAtom.is_schema_atom() && aAtom.as_schema_atom().is_schema_node_atom();
+            };
+            auto const rootIndex = index_of(&root());
+            for (std::size_t i = 0u; i < atoms.size(); ++i)
+            {
+                if (!is_node(*atoms[i]))
+                    continue;
+                auto const& node = atoms[i]->as_schema_atom().as_schema_node_atom();
+                if (node.is_token_node())
+                    index_of(&node.token());
+                for (auto const& expect : node.expects())
+                    index_of(pointer(expect));
+                for (auto const& token : node.tokens())
+                {
+                    index_of(pointer(token.first()));
+                    index_of(pointer(token.second()));
+                }
+                for (auto const& child : node.children())
+                {
+                    index_of(pointer(child.first()));
+                    index_of(pointer(child.second()));
+                }
+            }
+            image.write(static_cast<uint32_t>(atoms.size()));
+            image.write(rootIndex);
+            for (auto atom : atoms)
+            {
+                auto const parent = atom->has_parent() ? index_of(&atom->parent()) : schema_image::NoAtom;
+                if (atom->is_concept_atom())
+                {
+                    image.write(schema_image::atom_kind::Concept);
+                    image.write(parent);
+                    image.write_string(atom->as_concept_atom().get_concept().name().to_std_string());
+                }
+                else if (is_node(*atom))
+                {
+                    image.write(schema_image::atom_kind::SchemaNode);
+                    image.write(parent);
+                    image.write_string(atom->symbol().to_std_string());
+                }
+                else
+                {
+                    image.write(schema_image::atom_kind::SchemaTerminal);
+                    image.write(parent);
+                    image.write(static_cast<uint32_t>(atom->as_schema_atom().as_schema_terminal_atom().type()));
+                    image.write_string(atom->symbol().to_std_string());
+                }
+            }
+            for (auto atom : atoms)
+            {
+                if (!is_node(*atom))
+                    continue;
+                auto const& node = atom->as_schema_atom().as_schema_node_atom();
+                image.write(node.is_token_node() ? index_of(&node.token()) : schema_image::NoAtom);
+                image.write(static_cast<uint32_t>(node.is().size()));
+                for (auto const& concept_ : node.is())
+                    image.write_string(concept_->name().to_std_string());
+                image.write(static_cast<uint8_t>(node.as() ? 1u : 0u));
+                if (node.as())
+                    image.write_string(node.as()->name().to_std_string());
+                image.write(static_cast<uint32_t>(node.expects().size()));
+                for (auto const& expect : node.expects())
+                    image.write(index_of(pointer(expect)));
+                image.write(static_cast<uint8_t>(node.expect_none() ? 1u : 0u));
+                image.write(static_cast<uint32_t>(node.tokens().size()));
+                for (auto const& token : node.tokens())
+                {
+                    image.write(index_of(pointer(token.first())));
+                    image.write(index_of(pointer(token.second())));
+                }
+                image.write(static_cast<uint32_t>(node.children().size()));
+                for (auto const& child : node.children())
+                {
+                    image.write(index_of(pointer(child.first())));
+                    image.write(index_of(pointer(child.second())));
+                }
+                image.write(node.first_characters().bits());
+                image.write(node.lineage());
+            }
+            image.write(static_cast<uint32_t>(iNodes.size()));
+            for (auto node : iNodes)
+                image.write(index_of(node));
+            // the warnings are stored as located when built from source as an image has no source to locate them in
+            image.write(static_cast<uint32_t>(analysis().warnings().size()));
+            for (auto const& warning : analysis().warnings())
+            {
+                image.write(warning.kind);
+                image.write(static_cast<uint64_t>(warning.weight));
+                image.write_string(warning.text);
+            }
+            image.save(aPath);
+        }
+
+        schema_keyword schema::keyword(const neolib::rjson_string& aSymbol)
+        {
+            static std::map<std::string, schema_keyword> sKeywords = 
+            {
+                { "meta", schema_keyword::Meta},
+                { "libraries", schema_keyword::Libraries},
+                { "is", schema_keyword::Is},
+                { "as", schema_keyword::As},
+                { "done", schema_keyword::Done},
+                { "drain", schema_keyword::Drain},
+                { "next", schema_keyword::Next},
+                { "continue", schema_keyword::Continue},
+                { "ignore", schema_keyword::Ignore},
+                { "none", schema_keyword::None},
+                { "error", schema_keyword::Error},
+                { "default", schema_keyword::Default},
+                { "expect", schema_keyword::Expect},
+                { "tokens", schema_keyword::Tokens},
+            };
+            auto result = sKeywords.find(aSymbol);
+            if (result != sKeywords.end())
+                return result->second;
+            return schema_keyword::Invalid;
+        }
+
+        void schema::default_atom_handler(neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+        {
+            if (aChildNode.name_is_keyword())
+            {
+                if (keyword(aChildNode.name()) != schema_keyword::Invalid)
+                    throw_error(aChildNode, "unexpected keyword '" + aChildNode.name() + "'");
+                else if (aChildNode.type() != neolib::json_type::Object && !iParsingTokens)
+                    throw_error(aChildNode, "unexpected token match rule");
+            }
+            else if (!iParsingTokens)
+                throw_error(aChildNode, "unexpected token match rule");
+            auto newChild = aParentAtom.children().insert(
+                atom_ptr{ neolib::make_ref<schema_node_atom>(aParentAtom, aChildNode.name()) }, atom_ptr{});
+            iDefinitions[&*newChild->first()] = &aChildNode;
+            parse(aChildNode, newChild->first()->as_schema_atom().as_schema_node_atom());
+        }
+
+        schema::atom_handlers_t& schema::atom_handlers()
+        {
+            if (iAtomHandlers == std::nullopt)
+            {
+                iAtomHandlers = atom_handlers_t
+                {
+                    { schema_keyword::Meta, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        if (aChildNode.parent().is_root())
+                            parse_meta(aChildNode);
+                        else
+                            default_atom_handler(aChildNode, aParentAtom);
+                    } },
+                    { schema_keyword::Meta, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        if (aChildNode.parent().is_root())
+                            parse_meta(aChildNode);
+                        else
+                            default_atom_handler(aChildNode, aParentAtom);
+                    } },
+                    { schema_keyword::Libraries, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        if (aChildNode.parent().is_root())
+                            parse_meta(aChildNode);
+                        else
+                            default_atom_handler(aChildNode, aParentAtom);
+                    } },
+                    { schema_keyword::Is, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        auto const& conceptName = aChildNode.as<neolib::rjson_keyword>().text;
+                        auto concept_ = require_concept(conceptName);
+                        if (concept_ != nullptr)
+                            aParentAtom.is().push_back(concept_);
+                        else
+                            throw_error(aChildNode, "concept '" + conceptName + "' not found");
+                    } },
+                    { schema_keyword::As, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        auto const& conceptName = aChildNode.as<neolib::rjson_keyword>().text;
+                        auto concept_ = require_concept(conceptName);
+                        if (concept_ != nullptr)
+                            aParentAtom.as() = concept_;
+                        else
+                            throw_error(aChildNode, "concept '" + conceptName + "' not found");
+                    } },
+                    { schema_keyword::Default, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        parse_tokens(aChildNode, aParentAtom);
+                    } },
+                    { schema_keyword::Expect, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        if (aChildNode.type() != neolib::json_type::Keyword ||
+                            keyword(aChildNode.as<neolib::rjson_keyword>().text) != schema_keyword::None)
+                        {
+                            aParentAtom.expects().push_back(atom_ptr{});
+                            add_rhs_atom_reference(aChildNode, aParentAtom, aParentAtom.expects().back());
+                        }
+                        else
+                            aParentAtom.set_expect_none();
+                    } },
+                    { schema_keyword::Tokens, [this](neolib::rjson_value const& aChildNode, i_schema_node_atom& aParentAtom)
+                    {
+                        parse_tokens(aChildNode, aParentAtom);
+                    } }
+                };
+            }
+            return *iAtomHandlers;
+        }
+
+        void schema::parse(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom)
+        {
+            _limit_recursion_(schema);
+            for (auto const& childNode : aNode)
+            {
+                auto method = (childNode.name_is_keyword() ? atom_handlers().find(keyword(childNode.name())) : atom_handlers().end());
+                if (method != atom_handlers().end())
+                    method->second(childNode, aAtom);
+                else
+                    default_atom_handler(childNode, aAtom);
+            }
+        }
+
+        void schema::parse_meta(neolib::rjson_value const& aNode)
+        {
+            if (keyword(aNode.name()) == schema_keyword::Meta)
+            {
+                for (auto const& meta : aNode)
+                {
+                    if (meta.name() == "description")
+                        iMeta.description = meta.as<neolib::rjson_string>();
+                    else if (meta.name() == "copyright")
+                        iMeta.copyright = meta.as<neolib::rjson_string>();
+                    else if (meta.name() == "version")
+                        iMeta.version = meta.as<neolib::rjson_string>();
+                    else if (meta.name() == "source.file.extension")
+                    {
+                        if (meta.type() == neolib::json_type::String)
+                            iMeta.sourcecodeFileExtension.push_back(meta.as<neolib::rjson_string>());
+                        else
+                            for (auto const& ext : meta)
+                                iMeta.sourcecodeFileExtension.push_back(ext.as<neolib::rjson_string>());
+                    }
+                    else if (meta.name() == "source.source.package.specification.file.extension")
+                    {
+                        if (meta.type() == neolib::json_type::String)
+                            iMeta.sourcecodeModulePackageSpecificationFileExtension.push_back(meta.as<neolib::rjson_string>());
+                        else
+                            for (auto const& ext : meta)
+                                iMeta.sourcecodeModulePackageSpecificationFileExtension.push_back(ext.as<neolib::rjson_string>());
+                    }
+                    else if (meta.name() == "source.source.package.implementation.file.extension")
+                    {
+                        if (meta.type() == neolib::json_type::String)
+                            iMeta.sourcecodeModulePackageImplementationFileExtension.push_back(meta.as<neolib::rjson_string>());
+                        else
+                            for (auto const& ext : meta)
+                                iMeta.sourcecodeModulePackageImplementationFileExtension.push_back(ext.as<neolib::rjson_string>());
+                    }
+                }
+            }
+            else if (keyword(aNode.name()) == schema_keyword::Libraries)
+            {
+                for (auto const& library : aNode)
+                {
+                    if (!iConcepts.require_library(library.as<neolib::rjson_keyword>().text))
+                        throw_error(aNode, "concept library '" + library.as<neolib::rjson_keyword>().text + "' not found");
+                    iMeta.libraries.push_back(library.as<neolib::rjson_keyword>().text);
+                }
+            }
+        }
+
+        void schema::parse_tokens(neolib::rjson_value const& aNode, i_schema_node_atom& aAtom)
+        {
+            _limit_recursion_(schema);
+            neolib::scoped_flag sf{ iParsingTokens };
+            auto& result = aAtom.tokens();
+            auto parse_token_value = [&aAtom, &result](schema& aSchema, auto&& aToken)
+            {
+                aToken.visit([&aSchema, &aToken, &aAtom, &result](auto&& aNodeValue)
+                {
+                    typedef typename std::remove_cv<typename std::remove_reference<decltype(aNodeValue)>::type>::type type_t;
+                    if constexpr (std::is_same_v<type_t, neolib::rjson_keyword> || std::is_same_v<type_t, neolib::rjson_string>)
+                        aSchema.add_rhs_atom_reference(aToken, aAtom, result.back().second());
+                    else if constexpr (std::is_same_v<type_t, neolib::rjson_object>)
+                    {
+                        auto newNode = neolib::make_ref<schema_node_atom>(aAtom, aToken.name() + ".*");
+                        aSchema.iDefinitions[static_cast<const i_atom*>(&*newNode)] = &aToken;
+                        aSchema.add_lhs_atom_reference(aToken, aAtom, newNode->token_ref_ptr());
+                        result.back().second() = newNode;
+                        aSchema.parse_tokens(aToken, *newNode);
+                    }
+                }, false);
+            };
+            std::map<const char*, neolib::rjson_value::const_iterator> tokensInDocumentOrder;
+            for (auto iterToken = aNode.cbegin(); iterToken != aNode.cend(); ++iterToken)
+            {
+                auto const& token = *iterToken;
+                tokensInDocumentOrder[&token.name()[0]] = iterToken;
+            }
+            for (auto iterToken = tokensInDocumentOrder.cbegin(); iterToken != tokensInDocumentOrder.cend(); ++iterToken)
+            {
+                auto const& token = *iterToken->second;
+                switch (keyword(token.name()))
+                {
+                case schema_keyword::Expect:
+                    if (token.type() != neolib::json_type::Keyword ||
+                        keyword(token.as<neolib::rjson_keyword>().text) != schema_keyword::None)
+                    {
+                        aAtom.expects().push_back(atom_ptr{});
+                        add_rhs_atom_reference(token, aAtom, aAtom.expects().back());
+                    }
+                    else
+                        aAtom.set_expect_none();
+                    break;
+                case schema_keyword::Default:
+                    if (iterToken != std::prev(tokensInDocumentOrder.cend()))
+                        throw_error(token, "default specifier must appear last in token specification block");
+                    result.push_back(schema_node_atom::tokens_t::value_type{});
+                    result.back().first() = neolib::make_ref<schema_terminal_atom>(aAtom, schema_terminal::Default);
+                    iDefinitions[&result.back()] = &token;
+                    parse_token_value(*this, token);
+                    break;
+                case schema_keyword::Invalid:
+                    result.push_back(schema_node_atom::tokens_t::value_type{});
+                    add_lhs_atom_reference(token, aAtom, result.back().first());
+                    iDefinitions[&result.back()] = &token;
+                    parse_token_value(*this, token);
+                    break;
+                default:
+                    throw_error(aNode, "unexpected keyword '" + token.name() + "' in token specification");
+                    break;
+                }
+            }
+        }
+
+        std::string schema::fully_qualified_name(neolib::rjson_value const& aNode) const
+        {
+            _limit_recursion_(schema);
+            auto next_node = [&aNode]() -> neolib::rjson_value const&
+            {
+                for (auto n = &aNode; n->has_parent(); n = &n->parent())
+                    if (n->name_is_keyword() && (keyword(n->name()) == schema_keyword::Tokens || keyword(n->name()) == schema_keyword::Default))
+                        return n->parent();
+                return aNode;
+            };
+            auto const& nextNode = next_node();
+            if (nextNode.is_root())
+                return std::string{};
+            auto lhs = fully_qualified_name(nextNode.parent());
+            return lhs + (!lhs.empty() ? "." : std::string{}) + nextNode.name();
+        }
+
+        std::string schema::fully_qualified_name(neolib::rjson_value const& aNode, const neolib::rjson_string& aLeafName) const
+        {
+            auto lhs = fully_qualified_name(aNode);
+            return lhs + (!lhs.empty() ? "." : std::string{}) + aLeafName;
+        }
+
+        const schema::atom_references_t& schema::atom_references() const
+        {
+            return iAtomReferences;
+        }
+
+        schema::atom_references_t& schema::atom_references()
+        {
+            return iAtomReferences;
+        }
+
+        void schema::add_lhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom)
+        {
+            if (aNode.name_is_keyword())
+            {
+                if (keyword(aNode.name()) == schema_keyword::Invalid)
+                {
+                    auto const key = atom_reference_key_t{ aNode.name(), fully_qualified_name(aNode.parent(), aNode.name()) };
+                    atom_references()[key].push_back(atom_reference{ &aNode, &aAtom });
+                }
+                else
+                    throw_error(aNode, "unexpected keyword '" + aNode.name() + "'");
+            }
+            else
+                aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::String, aNode.name());
+        }
+
+        void schema::add_rhs_atom_reference(neolib::rjson_value const& aNode, i_schema_node_atom& aParentAtom, abstract_atom_ptr& aAtom)
+        {
+            aNode.visit([this, &aNode, &aParentAtom, &aAtom](auto&& aNodeValue)
+            {
+                typedef typename std::remove_cv<typename std::remove_reference<decltype(aNodeValue)>::type>::type type_t;
+                if constexpr (std::is_same_v<type_t, neolib::rjson_keyword>)
+                {
+                    switch (keyword(aNodeValue.text))
+                    {
+                    case schema_keyword::Invalid:
+                        {
+                            auto const key = atom_reference_key_t{ aNodeValue.text, fully_qualified_name(aNode.parent(), aNodeValue.text) };
+                            atom_references()[key].push_back(atom_reference{ &aNode, &aAtom });
+                        }
+                        break;
+                    case schema_keyword::Done:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Done);
+                        break;
+                    case schema_keyword::Drain:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Drain);
+                        break;
+                    case schema_keyword::Next:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Next);
+                        break;
+                    case schema_keyword::Continue:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Continue);
+                        break;
+                    case schema_keyword::Ignore:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Ignore);
+                        break;
+                    case schema_keyword::Error:
+                        aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::Error);
+                        break;
+                    default:
+                        throw_error(aNode, "unexpected keyword '" + aNodeValue.text + "'");
+                    }
+                }
+                else if constexpr (std::is_same_v<type_t, neolib::rjson_string>)
+                    aAtom = neolib::make_ref<schema_terminal_atom>(aParentAtom, schema_terminal::String, aNodeValue);
+            }, false);
+        }
+
+        void schema::index_nodes()
+        {
+            // dotted symbols are never a single path segment so nodes named with them (and their subtrees) are not reachable by leaf()
+            iNodeIndex.clear();
+            auto index = [this](auto& self, i_schema_node_atom& aNode, const std::string& aName) -> void
+            {
+                for (auto& child : aNode.children())
+                {
+                    auto& childAtom = *child.first();
+                    if (!childAtom.is_schema_atom() || !childAtom.as_schema_atom().is_schema_node_atom())
+                        continue;
+                    auto const symbol = childAtom.symbol().to_std_string();
+                    if (symbol.find('.') != std::string::npos)
+                        continue;
+                    auto const name = aName.empty() ? symbol : aName + "." + symbol;
+                    if (iNodeIndex.emplace(name, &childAtom.as_schema_atom().as_schema_node_atom()).second)
+                        self(self, childAtom.as_schema_atom().as_schema_node_atom(), name);
+                }
+            };
+            index(index, root(), std::string{});
+        }
+
+        void schema::resolve_references()
+        {
+            // leaf() and find_concept() only consult the node tree and the concept libraries, neither of which 
+            // resolving a reference changes, so a single pass reaches the fixed point
+            for (auto entry = atom_references().begin(); entry != atom_references().end();)
+            {
+                auto atom = leaf(entry->first.second, entry->first.first);
+                if (atom != nullptr)
+                {
+                    for (auto& r : entry->second)
+                        *r.atomPtr = atom;
+                    entry = atom_references().erase(entry);
+                    continue;
+                }
+                auto concept_ = require_concept(entry->first.first);
+                if (concept_ != nullptr)
+                {
+                    auto conceptAtom = create_concept_atom(concept_);
+                    for (auto& r : entry->second)
+                        *r.atomPtr = conceptAtom;
+                    entry = atom_references().erase(entry);
+                    continue;
+                }
+                ++entry;
+            }
+        }
+
+        void schema::compute_first_characters()
+        {
+            first_characters_t firstCharacters;
+            std::unordered_set<i_schema_node_atom*> visited;
+            iNodes.clear();
+            std::vector<i_schema_node_atom*> pending{ &root() };
+            auto visit = [&pending](i_atom& aAtom)
+            {
+                if (aAtom.is_schema_atom() && aAtom.as_schema_atom().is_schema_node_atom())
+                    pending.push_back(&aAtom.as_schema_atom().as_schema_node_atom());
+            };
+            while (!pending.empty())
+            {
+                auto& node = *pending.back();
+                pending.pop_back();
+                if (!visited.insert(&node).second)
+                    continue;
+                iNodes.push_back(&node);
+                first_characters(node, firstCharacters);
+                for (auto& child : node.children())
+                    visit(*child.first());
+                for (auto& token : node.tokens())
+                {
+                    if (token.first())
+                        visit(*token.first());
+                    if (token.second())
+                        visit(*token.second());
+                }
+                for (auto& expect : node.expects())
+                    visit(*expect);
+            }
+            for (auto& entry : firstCharacters)
+                entry.first->set_first_characters(*entry.second);
+        }
+
+        void schema::freeze_hierarchy()
+        {
+            uint32_t position = 0u;
+            auto tour = [&position](auto& self, i_schema_node_atom& aNode) -> void
+            {
+                hierarchy_interval lineage;
+                lineage.first = position++;
+                for (auto& child : aNode.children())
+                    if (child.first()->is_schema_atom() && child.first()->as_schema_atom().is_schema_node_atom() && aNode.is_parent_of(*child.first()))
+                        self(self, child.first()->as_schema_atom().as_schema_node_atom());
+                lineage.last = position;
+                aNode.set_lineage(lineage);
+            };
+            tour(tour, root());
+        }
+
+        void schema::read_image(schema_image& aImage)
+        {
+            auto read_strings = [&aImage](std::vector<std::string>& aStrings)
+            {
+                for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                    aStrings.push_back(aImage.read_string());
+            };
+            iMeta.name = aImage.read_string();
+            iMeta.description = aImage.read_string();
+            iMeta.copyright = aImage.read_string();
+            iMeta.version = aImage.read_string();
+            read_strings(iMeta.sourcecodeFileExtension);
+            read_strings(iMeta.sourcecodeModulePackageSpecificationFileExtension);
+            read_strings(iMeta.sourcecodeModulePackageImplementationFileExtension);
+            read_strings(iMeta.libraries);
+            // require the libraries the source names, as building from source does, so concepts resolve against the same libraries
+            for (auto const& library : iMeta.libraries)
+                if (!iConcepts.require_library(library))
+                    throw schema_image::bad_image();
+            iMeta.parserRecursionLimit = static_cast<std::size_t>(aImage.read<uint64_t>());
+            auto const atomCount = aImage.read<uint32_t>();
+            auto const rootIndex = aImage.read<schema_image::atom_index>();
+            std::vector<atom_ptr> atoms;
+            atoms.reserve(atomCount);
+            auto atom = [&atoms](schema_image::atom_index aIndex) -> atom_ptr
+            {
+                if (aIndex == schema_image::NoAtom)
+                    return atom_ptr{};
+                if (aIndex >= atoms.size())
+                    throw schema_image::bad_image();
+                return atoms[aIndex];
+            };
+            auto node = [&atom](schema_image::atom_index aIndex) -> i_schema_node_atom&
+            {
+                auto result = atom(aIndex);
+                if (result == nullptr || !result->is_schema_atom() || !result->as_schema_atom().is_schema_node_atom())
+                    throw schema_image::bad_image();
+                return result->as_schema_atom().as_schema_node_atom();
+            };
+            auto concept_ = [this](const std::string& aName)
+            {
+                auto result = require_concept(aName);
+                if (result == nullptr)
+                    throw schema_image::bad_image();
+                return result;
+            };
+            for (uint32_t i = 0u; i < atomCount; ++i)
+            {
+                auto const kind = aImage.read<schema_image::atom_kind>();
+                auto const parent = atom(aImage.read<schema_image::atom_index>());
+                switch (kind)
+                {
+                case schema_image::atom_kind::SchemaNode:
+                    {
+                        auto const symbol = aImage.read_string();
+                        if (parent == nullptr)
+                            atoms.push_back(atom_ptr{ neolib::make_ref<schema_node_atom>() });
+                        else
+                            atoms.push_back(atom_ptr{ neolib::make_ref<schema_node_atom>(parent->as_schema_atom(), symbol) });
+                    }
+                    break;
+                case schema_image::atom_kind::SchemaTerminal:
+                    {
+                        auto const type = static_cast<schema_terminal>(aImage.read<uint32_t>());
+                        auto const symbol = aImage.read_string();
+                        if (parent == nullptr)
+                            throw schema_image::bad_image();
+                        atoms.push_back(atom_ptr{ neolib::make_ref<schema_terminal_atom>(parent->as_schema_atom(), type, symbol) });
+                    }
+                    break;
+                case schema_image::atom_kind::Concept:
+                    {
+                        auto const c = concept_(aImage.read_string());
+                        if (parent == nullptr)
+                            atoms.push_back(atom_ptr{ neolib::make_ref<concept_atom>(c) });
+                        else
+                            atoms.push_back(atom_ptr{ neolib::make_ref<concept_atom>(parent->as_concept_atom(), c) });
+                    }
+                    break;
+                default:
+                    throw schema_image::bad_image();
+                }
+            }
+            for (auto& a : atoms)
+            {
+                if (!a->is_schema_atom() || !a->as_schema_atom().is_schema_node_atom())
+                    continue;
+                auto& n = a->as_schema_atom().as_schema_node_atom();
+                n.token_ref_ptr() = atom(aImage.read<schema_image::atom_index>());
+                for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                    n.is().push_back(concept_(aImage.read_string()));
+                if (aImage.read<uint8_t>() != 0u)
+                    n.as() = concept_(aImage.read_string());
+                for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                    n.expects().push_back(atom(aImage.read<schema_image::atom_index>()));
+                if (aImage.read<uint8_t>() != 0u)
+                    n.set_expect_none();
+                for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                {
+                    n.tokens().push_back(schema_node_atom::tokens_t::value_type{});
+                    n.tokens().back().first() = atom(aImage.read<schema_image::atom_index>());
+                    n.tokens().back().second() = atom(aImage.read<schema_image::atom_index>());
+                }
+                for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                {
+                    auto const key = atom(aImage.read<schema_image::atom_index>());
+                    auto const value = atom(aImage.read<schema_image::atom_index>());
+                    n.children().insert(key, value);
+                }
+                n.set_first_characters(character_set{ aImage.read<character_set::bits_t>() });
+                n.set_lineage(aImage.read<hierarchy_interval>());
+            }
+            iRoot = atom_ptr{ &node(rootIndex) };
+            iNodes.clear();
+            for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+                iNodes.push_back(&node(aImage.read<schema_image::atom_index>()));
+            grammar_analysis::warnings_t warnings;
+            for (auto count = aImage.read<uint32_t>(); count > 0u; --count)
+            {
+                auto const kind = aImage.read<grammar_analysis::finding>();
+                auto const weight = static_cast<std::size_t>(aImage.read<uint64_t>());
+                warnings.push_back(grammar_analysis::warning{ kind, weight, aImage.read_string() });
+            }
+            iAnalysis.emplace(warnings);
+        }
+
+        void schema::create_parse_table()
+        {
+            iParseTable.emplace(iNodes);
+        }
+
+        void schema::analyze()
+        {
+            iAnalysis.emplace(iNodes, [this](const void* aDefinition, const std::string& aText) -> std::string
+            {
+                auto definition = iDefinitions.find(aDefinition);
+                if (iSource != nullptr && definition != iDefinitions.end() && definition->second->has_name())
+                    return iSource->to_error_text(*definition->second, aText);
+                return aText;
+            });
+        }
+
+        character_set schema::first_characters(i_atom& aAtom, first_characters_t& aFirstCharacters)
+        {
+            if (!aAtom.is_schema_atom() || !aAtom.as_schema_atom().is_schema_node_atom())
+                return aAtom.first_characters();
+            auto& node = aAtom.as_schema_atom().as_schema_node_atom();
+            auto existing = aFirstCharacters.find(&node);
+            if (existing != aFirstCharacters.end())
+                return existing->second ? *existing->second : character_set::all(); // left recursion
+            aFirstCharacters[&node] = std::nullopt;
+            // only nodes that are a plain choice of tokens have a FIRST set narrower than everything
+            character_set result;
+            if (!node.expects().empty() || node.expect_none() || node.is_token_node() || node.tokens().empty())
+                result = character_set::all();
+            else
+            {
+                for (auto& token : node.tokens())
+                {
+                    auto& key = *token.first();
+                    if (key.is_schema_atom() && key.as_schema_atom().is_schema_terminal_atom() &&
+                        key.as_schema_atom().as_schema_terminal_atom().type() == schema_terminal::Default)
+                    {
+                        bool noMatch = false;
+                        if (token.second() && token.second()->is_schema_atom() && token.second()->as_schema_atom().is_schema_terminal_atom())
+                            switch (token.second()->as_schema_atom().as_schema_terminal_atom().type())
+                            {
+                            case schema_terminal::Next:
+                            case schema_terminal::Done:
+                            case schema_terminal::Drain:
+                            case schema_terminal::Error:
+                                noMatch = true;
+                                break;
+                            default:
+                                break;
+                            }
+                        if (!noMatch)
+                            result = character_set::all();
+                    }
+                    else
+                        result |= first_characters(key, aFirstCharacters);
+                    if (result.full())
+                        break;
+                }
+            }
+            aFirstCharacters[&node] = result;
+            return result;
+        }
+
+        schema::atom_ptr schema::leaf(const std::string& aStem, const neolib::rjson_string& aLeafName)
+        {
+            // descend the stem one segment at a time then search enclosing scopes outwards; the scope path 
+            // doubles as the parent chain as every node on it was reached through its parent's children
+            std::vector<std::pair<i_schema_node_atom*, std::string>> scopes{ { &root(), std::string{} } };
+            std::string stem = aStem;
+            std::string leafName = aLeafName;
+            for (;;)
+            {
+                auto& node = *scopes.back().first;
+                if (stem == node.symbol() && leafName == stem)
+                    return atom_ptr{ &node };
+                for (auto& concept_ : node.is())
+                {
+                    if (concept_->name() == neolib::string{ leafName })
+                        return neolib::make_ref<concept_atom>(concept_);
+                    auto const base = concept_->name().to_std_string() + ".";
+                    auto matchingConcept = find_concept(base + leafName);
+                    if (matchingConcept == nullptr && leafName.find(base) == 0)
+                        matchingConcept = find_concept(leafName);
+                    if (matchingConcept != nullptr)
+                        return create_concept_atom(matchingConcept);
+                }
+                auto const delim = stem.find('.');
+                auto const head = stem.substr(0, delim);
+                auto const name = scopes.back().second.empty() ? head : scopes.back().second + "." + head;
+                auto child = iNodeIndex.find(name);
+                if (child != iNodeIndex.end())
+                {
+                    if (delim == std::string::npos)
+                        return atom_ptr{ child->second };
+                    auto newStem = stem.substr(delim + 1);
+                    if (leafName == stem)
+                        leafName = newStem;
+                    stem = std::move(newStem);
+                    scopes.emplace_back(child->second, name);
+                    continue;
+                }
+                if (scopes.size() == 1u)
+                    return atom_ptr{};
+                scopes.pop_back();
+            }
+        }
+
+        schema::atom_ptr schema::create_concept_atom(const neolib::i_ref_ptr<i_concept>& aConcept)
+        {
+            auto iterConceptAtom = iConceptAtoms.find(&*aConcept);
+            if (iterConceptAtom == iConceptAtoms.end())
+                iterConceptAtom = iConceptAtoms.emplace(&*aConcept, neolib::make_ref<concept_atom>(aConcept)).first;
+            return iterConceptAtom->second;
+        }
+
+        neolib::ref_ptr<i_concept> schema::find_concept(const std::string& aSymbol) const
+        {
+            return iConcepts.find_concept(aSymbol);
+        }
+
+        neolib::ref_ptr<i_concept> schema::require_concept(const std::string& aSymbol) const
+        {
+            return iConcepts.require_concept(aSymbol);
+        }
+
+        void schema::throw_error(neolib::rjson_value const& aNode, const std::string aErrorText)
+        {
+            if (aNode.has_name() && iSource != nullptr)
+                throw std::runtime_error(iSource->to_error_text(aNode, aErrorText));
+            throw std::runtime_error(aErrorText);
+        }
+   }
 }
\ No newline at end of file
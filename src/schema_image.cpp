@@ -0,0 +1,152 @@
+/*
+  schema_image.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <neos/language/schema_image.hpp>
+
+namespace neos::language
+{
+    namespace
+    {
+        constexpr char ImageMagic[8] = { 'N', 'E', 'O', 'S', 'S', 'C', 'H', 'M' };
+        constexpr uint32_t ByteOrderMark = 0x01020304u;
+    }
+
+    schema_image::schema_image(const std::string& aPath) :
+        iCursor{ nullptr }, iEnd{ nullptr }
+    {
+        try
+        {
+            iFile = boost::interprocess::file_mapping{ aPath.c_str(), boost::interprocess::read_only };
+            iRegion = boost::interprocess::mapped_region{ iFile, boost::interprocess::read_only };
+        }
+        catch (const boost::interprocess::interprocess_exception&)
+        {
+            throw bad_image();
+        }
+        iCursor = static_cast<const char*>(iRegion.get_address());
+        iEnd = iCursor + iRegion.get_size();
+        for (auto ch : ImageMagic)
+            if (read<char>() != ch)
+                throw bad_image();
+        if (read<uint32_t>() != FormatVersion || read<uint32_t>() != ByteOrderMark)
+            throw bad_image();
+        iStamp.source = read<uint64_t>();
+        iStamp.libraries = read<uint64_t>();
+    }
+
+    std::string schema_image::default_cache_directory()
+    {
+        return (boost::filesystem::temp_directory_path() / "neos" / "schema_images").string();
+    }
+
+    std::string schema_image::path(const std::string& aCacheDirectory, const std::string& aSourcePath)
+    {
+        auto const source = boost::filesystem::absolute(aSourcePath).lexically_normal();
+        fnv1a sourcePathHash;
+        sourcePathHash.add(source.generic_string());
+        std::ostringstream name;
+        name << source.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << sourcePathHash.hash() << ".image";
+        return (boost::filesystem::path{ aCacheDirectory } / name.str()).string();
+    }
+
+    schema_image::version_stamp schema_image::compute_stamp(const std::string& aSourcePath, const std::string& aPluginsFingerprint)
+    {
+        version_stamp result;
+        std::ifstream source{ aSourcePath, std::ios::binary };
+        if (!source)
+            throw bad_image();
+        std::ostringstream sourceText;
+        sourceText << source.rdbuf();
+        fnv1a sourceHash;
+        sourceHash.add(sourceText.str());
+        result.source = sourceHash.hash();
+        fnv1a librariesHash;
+        std::ostringstream neosVersion;
+        neosVersion << NEOS_VERSION;
+        librariesHash.add(neosVersion.str());
+        librariesHash.add(aPluginsFingerprint);
+        result.libraries = librariesHash.hash();
+        return result;
+    }
+
+    const schema_image::version_stamp& schema_image::stamp() const
+    {
+        return iStamp;
+    }
+
+    std::string schema_image::read_string()
+    {
+        auto const length = read<uint32_t>();
+        if (static_cast<std::size_t>(iEnd - iCursor) < length)
+            throw bad_image();
+        std::string result{ iCursor, length };
+        iCursor += length;
+        return result;
+    }
+
+    schema_image_writer::schema_image_writer(const schema_image::version_stamp& aStamp)
+    {
+        for (auto ch : ImageMagic)
+            write(ch);
+        write(schema_image::FormatVersion);
+        write(ByteOrderMark);
+        write(aStamp.source);
+        write(aStamp.libraries);
+    }
+
+    void schema_image_writer::write_string(const std::string& aString)
+    {
+        write(static_cast<uint32_t>(aString.size()));
+        iBuffer.insert(iBuffer.end(), aString.begin(), aString.end());
+    }
+
+    void schema_image_writer::save(const std::string& aPath) const
+    {
+        // write a temporary unique to this writer and rename it so a concurrent reader never maps a partial image 
+        // and concurrent writers of the same image never share a file
+        boost::filesystem::path const path{ aPath };
+        auto const directory = path.parent_path();
+        if (!directory.empty())
+            boost::filesystem::create_directories(directory);
+        auto const temporaryPath = boost::filesystem::unique_path(directory / (path.filename().string() + ".%%%%-%%%%-%%%%-%%%%.tmp")).string();
+        try
+        {
+            {
+                std::ofstream output{ temporaryPath, std::ios::binary | std::ios::trunc };
+                if (!output)
+                    throw std::runtime_error("cannot open '" + temporaryPath + "'");
+                output.write(iBuffer.data(), iBuffer.size());
+                if (!output)
+                    throw std::runtime_error("cannot write '" + temporaryPath + "'");
+            }
+            boost::filesystem::rename(temporaryPath, path);
+        }
+        catch (...)
+        {
+            boost::system::error_code ignored;
+            boost::filesystem::remove(temporaryPath, ignored);
+            throw;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+  static_concept_libraries.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <neos/language/concept_library_plugin.hpp>
+#include <neos/language/static_concept_libraries.hpp>
+
+#ifdef NEOS_STATIC_CORE_CONCEPTS
+#include "../concepts/src/core/core.cpp"
+#include "../concepts/src/core/module.cpp"
+#include "../concepts/src/core/language.cpp"
+#include "../concepts/src/core/boolean.cpp"
+#include "../concepts/src/core/logic.cpp"
+#include "../concepts/src/core/math.cpp"
+#include "../concepts/src/core/string.cpp"
+#include "../concepts/src/core/object.cpp"
+#include "../concepts/src/core/math.universal.cpp"
+#endif
+
+namespace neos
+{
+    namespace language
+    {
+        bool static_core_concepts()
+        {
+#ifdef NEOS_STATIC_CORE_CONCEPTS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void static_concept_library_plugins(std::vector<neolib::ref_ptr<neolib::i_plugin>>& aPlugins)
+        {
+#ifdef NEOS_STATIC_CORE_CONCEPTS
+            aPlugins.push_back(neolib::make_ref<concept_library_plugin<concepts::core::core>>());
+            aPlugins.push_back(neolib::make_ref<concept_library_plugin<concepts::core::math_universal>>());
+#endif
+        }
+    }
+}
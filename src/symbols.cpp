@@ -0,0 +1,164 @@
+/*
+  symbols.cpp
+
+  Copyright (c) 2019 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neos/neos.hpp>
+#include <algorithm>
+#include <functional>
+#include <neos/language/symbols.hpp>
+
+namespace neos::language
+{
+    symbol_table::symbol_table() :
+        iNameMask{ 0u }, iDefinitionMask{ 0u }, iDefinitionCount{ 0u }
+    {
+    }
+
+    symbol_handle_t symbol_table::intern(std::string_view aName)
+    {
+        reserve_names(iNames.size() + 1u);
+        auto const hash = std::hash<std::string_view>{}(aName);
+        auto& slot = find_name_slot(hash, aName);
+        if (slot == NoSymbol)
+        {
+            slot = static_cast<symbol_handle_t>(iNames.size());
+            iNames.push_back(name_entry{ static_cast<uint32_t>(iPool.size()), static_cast<uint32_t>(aName.size()), hash });
+            iPool.append(aName);
+        }
+        return slot;
+    }
+
+    symbol_handle_t symbol_table::find(std::string_view aName) const
+    {
+        if (iNameSlots.empty())
+            return NoSymbol;
+        auto const hash = std::hash<std::string_view>{}(aName);
+        for (auto index = hash & iNameMask; iNameSlots[index] != NoSymbol; index = (index + 1u) & iNameMask)
+            if (iNames[iNameSlots[index]].hash == hash && name(iNameSlots[index]) == aName)
+                return iNameSlots[index];
+        return NoSymbol;
+    }
+
+    std::string_view symbol_table::name(symbol_handle_t aSymbol) const
+    {
+        auto const& entry = iNames[aSymbol];
+        return std::string_view{ iPool.data() + entry.offset, entry.length };
+    }
+
+    std::size_t symbol_table::names() const
+    {
+        return iNames.size();
+    }
+
+    void symbol_table::define(const key& aKey, symbol_reference_t aReference)
+    {
+        reserve_definitions(iDefinitionCount + 1u);
+        auto& slot = find_definition_slot(aKey);
+        if (slot.symbol.name == NoSymbol)
+        {
+            slot.symbol = aKey;
+            ++iDefinitionCount;
+        }
+        slot.reference = aReference;
+    }
+
+    const symbol_reference_t* symbol_table::find(const key& aKey) const
+    {
+        if (iDefinitions.empty())
+            return nullptr;
+        for (auto index = hash(aKey) & iDefinitionMask; iDefinitions[index].symbol.name != NoSymbol; index = (index + 1u) & iDefinitionMask)
+            if (iDefinitions[index].symbol.name == aKey.name && iDefinitions[index].symbol.type == aKey.type)
+                return &iDefinitions[index].reference;
+        return nullptr;
+    }
+
+    const symbol_reference_t* symbol_table::find(symbol_type aType, std::string_view aName) const
+    {
+        auto const name = find(aName);
+        return name != NoSymbol ? find(key{ aType, name }) : nullptr;
+    }
+
+    std::size_t symbol_table::size() const
+    {
+        return iDefinitionCount;
+    }
+
+    void symbol_table::clear()
+    {
+        iPool.clear();
+        iNames.clear();
+        iNameSlots.clear();
+        iNameMask = 0u;
+        iDefinitions.clear();
+        iDefinitionMask = 0u;
+        iDefinitionCount = 0u;
+    }
+
+    void symbol_table::reserve_names(std::size_t aNames)
+    {
+        // keep the load factor at or below one half
+        if (!iNameSlots.empty() && aNames * 2u <= iNameSlots.size())
+            return;
+        std::size_t capacity = std::max<std::size_t>(iNameSlots.size(), 16u);
+        while (capacity < aNames * 2u)
+            capacity *= 2u;
+        iNameSlots.assign(capacity, NoSymbol);
+        iNameMask = capacity - 1u;
+        for (symbol_handle_t existing = 0u; existing < iNames.size(); ++existing)
+            find_name_slot(iNames[existing].hash, name(existing)) = existing;
+    }
+
+    void symbol_table::reserve_definitions(std::size_t aDefinitions)
+    {
+        if (!iDefinitions.empty() && aDefinitions * 2u <= iDefinitions.size())
+            return;
+        std::size_t capacity = std::max<std::size_t>(iDefinitions.size(), 16u);
+        while (capacity < aDefinitions * 2u)
+            capacity *= 2u;
+        std::vector<definition> oldDefinitions(capacity, definition{ key{ symbol_type::Function, NoSymbol }, nullptr });
+        oldDefinitions.swap(iDefinitions);
+        iDefinitionMask = capacity - 1u;
+        for (auto const& old : oldDefinitions)
+            if (old.symbol.name != NoSymbol)
+                find_definition_slot(old.symbol) = old;
+    }
+
+    uint32_t& symbol_table::find_name_slot(std::size_t aHash, std::string_view aName)
+    {
+        auto index = aHash & iNameMask;
+        for (; iNameSlots[index] != NoSymbol; index = (index + 1u) & iNameMask)
+            if (iNames[iNameSlots[index]].hash == aHash && name(iNameSlots[index]) == aName)
+                break;
+        return iNameSlots[index];
+    }
+
+    symbol_table::definition& symbol_table::find_definition_slot(const key& aKey)
+    {
+        auto index = hash(aKey) & iDefinitionMask;
+        for (; iDefinitions[index].symbol.name != NoSymbol; index = (index + 1u) & iDefinitionMask)
+            if (iDefinitions[index].symbol.name == aKey.name && iDefinitions[index].symbol.type == aKey.type)
+                break;
+        return iDefinitions[index];
+    }
+
+    std::size_t symbol_table::hash(const key& aKey)
+    {
+        // handles are dense so spread them with a Fibonacci multiply and keep the upper half
+        return static_cast<std::size_t>(((static_cast<uint64_t>(aKey.name) << 1u | static_cast<uint64_t>(aKey.type)) * 0x9E3779B97F4A7C15ull) >> 32u);
+    }
+}